@@ -0,0 +1,15 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+import QtQuick
+
+import org.kde.plasma.configuration
+
+ConfigModel {
+    ConfigCategory {
+        name: i18n("General")
+        icon: "configure"
+        source: "ConfigGeneral.qml"
+    }
+}
@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+import QtQuick
+import QtQuick.Layouts
+
+import org.kde.plasma.components as PlasmaComponents
+
+import org.kde.plasma.private.plasmapass
+
+import org.kde.kirigami as Kirigami
+
+ColumnLayout {
+    id: page
+
+    property Item stack
+    property PasswordAudit audit
+
+    function activateCurrentItem() {
+        startButton.clicked();
+    }
+
+    spacing: Kirigami.Units.smallSpacing
+
+    RowLayout {
+        Layout.fillWidth: true
+        Layout.margins: Kirigami.Units.smallSpacing * 2
+
+        PlasmaComponents.Label {
+            Layout.fillWidth: true
+            visible: !page.audit.running
+            wrapMode: Text.Wrap
+            text: page.audit.folder === ""
+                ? i18n("Look for weak and reused passwords and entries without OTP in all passwords.")
+                : i18n("Look for weak and reused passwords and entries without OTP in %1.", page.audit.folder)
+        }
+
+        PlasmaComponents.ProgressBar {
+            Layout.fillWidth: true
+            visible: page.audit.running
+            from: 0
+            to: Math.max(page.audit.total, 1)
+            value: page.audit.done
+        }
+
+        PlasmaComponents.Button {
+            id: startButton
+            text: page.audit.running ? i18n("Cancel") : i18n("Start")
+            icon.name: page.audit.running ? "dialog-cancel" : "media-playback-start"
+            onClicked: {
+                if (page.audit.running) {
+                    page.audit.cancel();
+                } else {
+                    page.audit.start();
+                }
+            }
+        }
+    }
+
+    PlasmaComponents.Label {
+        Layout.fillWidth: true
+        Layout.leftMargin: Kirigami.Units.smallSpacing * 2
+        Layout.rightMargin: Kirigami.Units.smallSpacing * 2
+        visible: listView.count > 0
+        wrapMode: Text.Wrap
+        text: i18n("%1 weak, %2 reused, %3 without OTP, %4 failed",
+                   page.audit.weakCount, page.audit.reusedCount, page.audit.missingOtpCount, page.audit.failedCount)
+    }
+
+    PlasmaComponents.ScrollView {
+        Layout.fillWidth: true
+        Layout.fillHeight: true
+        background: null
+
+        contentItem: ListView {
+            id: listView
+
+            model: page.audit
+            leftMargin: Kirigami.Units.smallSpacing * 2
+            rightMargin: Kirigami.Units.smallSpacing * 2
+            spacing: Kirigami.Units.smallSpacing
+
+            delegate: ColumnLayout {
+                width: listView.width - Kirigami.Units.smallSpacing * 4
+                spacing: 0
+
+                function issues() {
+                    if (model.error !== "") {
+                        return model.error;
+                    }
+                    let issues = [];
+                    if (model.strength < 2) {
+                        issues.push(i18n("Weak password"));
+                    }
+                    if (model.reused > 0) {
+                        issues.push(i18np("Same password as one other entry", "Same password as %1 other entries", model.reused));
+                    }
+                    if (!model.hasOtp) {
+                        issues.push(i18n("No OTP"));
+                    }
+                    return issues.length > 0 ? issues.join(", ") : i18n("No issues found");
+                }
+
+                PlasmaComponents.Label {
+                    Layout.fillWidth: true
+                    elide: Text.ElideRight
+                    text: model.fullName
+                }
+
+                PlasmaComponents.Label {
+                    Layout.fillWidth: true
+                    elide: Text.ElideRight
+                    opacity: 0.7
+                    font: Kirigami.Theme.smallFont
+                    text: parent.issues()
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+import QtQuick
+import QtQuick.Controls as QQC2
+import QtQuick.Layouts
+
+import org.kde.kcmutils as KCM
+import org.kde.kirigami as Kirigami
+
+KCM.SimpleKCM {
+    property alias cfg_fuzzyMatching: fuzzyMatching.checked
+    property alias cfg_searchMetadata: searchMetadata.checked
+    property alias cfg_otpSessionMinutes: otpSession.value
+
+    Kirigami.FormLayout {
+        QQC2.CheckBox {
+            id: fuzzyMatching
+
+            Kirigami.FormData.label: i18n("Search:")
+            text: i18n("Tolerate typos when there are few matches")
+        }
+
+        QQC2.CheckBox {
+            id: searchMetadata
+
+            text: i18n("Also in logins, URLs and other non-secret fields")
+        }
+
+        QQC2.Label {
+            Layout.fillWidth: true
+            wrapMode: Text.Wrap
+            font: Kirigami.Theme.smallFont
+            text: i18n("Every entry is decrypted once to build an encrypted index of these fields, which can ask for the passphrase.")
+        }
+
+        Item {
+            Kirigami.FormData.isSection: true
+        }
+
+        QQC2.SpinBox {
+            id: otpSession
+
+            Kirigami.FormData.label: i18n("Keep OTP codes coming for:")
+            from: 0
+            to: 24 * 60
+            textFromValue: (value, locale) => value === 0 ? i18n("Single code") : i18np("%1 minute", "%1 minutes", value)
+            valueFromText: (text, locale) => parseInt(text) || 0
+        }
+
+        QQC2.Label {
+            Layout.fillWidth: true
+            wrapMode: Text.Wrap
+            font: Kirigami.Theme.smallFont
+            text: i18n("During this time a new OTP code replaces the old one at every step without decrypting the entry again. The OTP secret stays in memory meanwhile, it is wiped when the time is up or the screen gets locked.")
+        }
+    }
+}
@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+import QtQuick
+import QtQuick.Layouts
+
+import org.kde.plasma.components as PlasmaComponents
+
+import org.kde.plasma.private.plasmapass
+
+import org.kde.kirigami as Kirigami
+
+ColumnLayout {
+    id: page
+
+    property Item stack
+    property alias folder: dashboard.folder
+
+    function activateCurrentItem() {
+        if (!dashboard.loading) {
+            dashboard.start();
+        }
+    }
+
+    spacing: Kirigami.Units.smallSpacing
+
+    // Owned by the page, the keys are wiped once the page is closed
+    OTPDashboard {
+        id: dashboard
+    }
+
+    Component.onCompleted: dashboard.start()
+
+    PlasmaComponents.ProgressBar {
+        Layout.fillWidth: true
+        Layout.margins: Kirigami.Units.smallSpacing * 2
+        visible: dashboard.loading
+        from: 0
+        to: Math.max(dashboard.total, 1)
+        value: dashboard.done
+    }
+
+    // One countdown for all codes, they all change at the same time
+    PlasmaComponents.ProgressBar {
+        id: countdownBar
+
+        Layout.fillWidth: true
+        Layout.leftMargin: Kirigami.Units.smallSpacing * 2
+        Layout.rightMargin: Kirigami.Units.smallSpacing * 2
+        visible: listView.count > 0
+
+        from: 0
+        to: 30000
+
+        readonly property real nextRefresh: dashboard.nextRefresh
+        // Only while it can be seen, the popup window is hidden while the plasmoid is collapsed
+        readonly property bool animating: visible && Window.window !== null && Window.window.visible
+        onNextRefreshChanged: restartCountdown()
+        onAnimatingChanged: restartCountdown()
+
+        function restartCountdown() {
+            countdown.stop();
+            const remaining = Math.max(0, nextRefresh - Date.now());
+            to = Math.max(remaining, 30000);
+            value = remaining;
+            if (animating && remaining > 0) {
+                countdown.from = remaining;
+                countdown.duration = remaining;
+                countdown.start();
+            }
+        }
+
+        NumberAnimation {
+            id: countdown
+            target: countdownBar
+            property: "value"
+            to: 0
+        }
+    }
+
+    PlasmaComponents.Label {
+        Layout.fillWidth: true
+        Layout.leftMargin: Kirigami.Units.smallSpacing * 2
+        Layout.rightMargin: Kirigami.Units.smallSpacing * 2
+        visible: !dashboard.loading && (listView.count === 0 || dashboard.failedCount > 0)
+        wrapMode: Text.Wrap
+        text: listView.count === 0 && dashboard.failedCount === 0
+            ? i18n("No entries with OTP found.")
+            : i18np("One entry could not be decrypted.", "%1 entries could not be decrypted.", dashboard.failedCount)
+    }
+
+    PlasmaComponents.ScrollView {
+        Layout.fillWidth: true
+        Layout.fillHeight: true
+        background: null
+
+        contentItem: ListView {
+            id: listView
+
+            model: dashboard
+            leftMargin: Kirigami.Units.smallSpacing * 2
+            rightMargin: Kirigami.Units.smallSpacing * 2
+            spacing: Kirigami.Units.smallSpacing
+
+            delegate: RowLayout {
+                width: listView.width - Kirigami.Units.smallSpacing * 4
+
+                PlasmaComponents.Label {
+                    Layout.fillWidth: true
+                    elide: Text.ElideRight
+                    text: model.fullName
+                }
+
+                PlasmaComponents.Label {
+                    font.family: "monospace"
+                    font.pointSize: Kirigami.Theme.defaultFont.pointSize * 1.2
+                    text: model.code
+                }
+            }
+        }
+    }
+}
@@ -16,7 +16,9 @@ import org.kde.kirigami as Kirigami
 MouseArea {
     id: root
 
-    property alias name: label.text
+    property string name
+    // Matched characters of the name as a flat list of start and length pairs
+    property var matchRanges: []
     property string icon
     property var entryType
 
@@ -116,7 +118,24 @@ MouseArea {
                 maximumLineCount: 1
                 verticalAlignment: Text.AlignLeft
                 elide: Text.ElideRight
-                textFormat: Text.PlainText
+                textFormat: root.matchRanges.length > 0 ? Text.StyledText : Text.PlainText
+                text: root.matchRanges.length > 0 ? highlighted(root.name, root.matchRanges) : root.name
+
+                function escaped(text) {
+                    return text.replace(/&/g, "&amp;").replace(/</g, "&lt;").replace(/>/g, "&gt;");
+                }
+
+                function highlighted(text, ranges) {
+                    let result = "";
+                    let pos = 0;
+                    for (let i = 0; i + 1 < ranges.length; i += 2) {
+                        const start = ranges[i];
+                        const end = start + ranges[i + 1];
+                        result += escaped(text.substring(pos, start)) + "<b>" + escaped(text.substring(start, end)) + "</b>";
+                        pos = end;
+                    }
+                    return result + escaped(text.substring(pos));
+                }
             }
 
             PlasmaComponents.ToolButton {
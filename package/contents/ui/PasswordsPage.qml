@@ -81,6 +81,7 @@ PlasmaComponents.ScrollView {
                 id: delegate
 
                 name: model.name
+                matchRanges: model.matchRanges || []
                 icon: model.type === PasswordsModel.FolderEntry ? "inode-directory" : "lock"
                 entryType: model.type
                 width: listView.width - Kirigami.Units.smallSpacing * 4
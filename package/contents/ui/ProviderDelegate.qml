@@ -35,7 +35,32 @@ RowLayout {
 
             from: 0
             to: root.provider == null ? 0 : root.provider.defaultTimeout
-            value: root.provider == null ? 0 : root.provider.timeout
+
+            // The provider only says when the secret expires, the countdown is animated here
+            readonly property real expiresAt: root.provider == null ? 0 : root.provider.expiresAt
+            // Only while it can be seen, the popup window is hidden while the plasmoid is collapsed
+            readonly property bool animating: visible && Window.window !== null && Window.window.visible
+            onExpiresAtChanged: restartCountdown()
+            onAnimatingChanged: restartCountdown()
+            Component.onCompleted: restartCountdown()
+
+            function restartCountdown() {
+                countdown.stop();
+                const remaining = Math.max(0, expiresAt - Date.now());
+                value = remaining;
+                if (animating && remaining > 0) {
+                    countdown.from = remaining;
+                    countdown.duration = remaining;
+                    countdown.start();
+                }
+            }
+
+            NumberAnimation {
+                id: countdown
+                target: timeoutBar
+                property: "value"
+                to: 0
+            }
         }
 
         PlasmaComponents3.Label {
@@ -39,12 +39,16 @@ PlasmoidItem {
 
         onExpandedChanged: {
             if (expanded) {
+                // The user is about to pick an entry, get GnuPG ready meanwhile
+                DecryptionService.warmUp();
                 filterField.focus = true;
                 filterField.forceActiveFocus();
             } else {
                 filterField.text = "";
                 viewStack.pop(null);
                 currentPath.clearName();
+                // Whatever is still waiting for a worker is of no use anymore
+                DecryptionService.cancelWaiting();
             }
         }
         header: PlasmaExtras.PlasmoidHeading {
@@ -58,15 +62,44 @@ PlasmoidItem {
                     isSortLocaleAware: true
                     sortCaseSensitivity: Qt.CaseInsensitive
 
-                    sourceModel: PasswordsModel {}
+                    sourceModel: PasswordsModel {
+                        id: passwordsTree
+
+                        otpSession: Plasmoid.configuration.otpSessionMinutes * 60
+                    }
                 }
 
                 PasswordFilterModel {
                     id: filterModel
 
                     passwordFilter: filterField.text
+                    fuzzyMatching: Plasmoid.configuration.fuzzyMatching
+                    searchMetadata: Plasmoid.configuration.searchMetadata
+                    searchRoot: folderScopeButton.visible && folderScopeButton.checked ? viewStack.searchFolder : undefined
+
+                    sourceModel: passwordsTree
+                }
+
+                // Lives outside of the page, so the audit goes on while the popup is closed
+                PasswordAudit {
+                    id: passwordAudit
+                }
+
+                Component {
+                    id: auditPage
+
+                    AuditPage {
+                        stack: viewStack
+                        audit: passwordAudit
+                    }
+                }
 
-                    sourceModel: passwordsModel
+                Component {
+                    id: otpDashboardPage
+
+                    OTPDashboardPage {
+                        stack: viewStack
+                    }
                 }
 
                 Component {
@@ -121,29 +154,76 @@ PlasmoidItem {
                             text = _path.join("/");
                         }
                         function clearName() {
-                            _path = []
+                            _path = [];
+                            text = "";
                         }
                     }
                 }
 
-                PlasmaComponents.TextField {
-                    id: filterField
-                    focus: true
-                    activeFocusOnTab: true
+                RowLayout {
+                    PlasmaComponents.TextField {
+                        id: filterField
+                        focus: true
+                        activeFocusOnTab: true
+
+                        placeholderText: i18n("Filter...")
+                        clearButtonShown: true
+
+                        Layout.fillWidth: true
+
+                        Keys.priority: Keys.BeforeItem
+                        Keys.onPressed: event=> {
+                            if (event.key == Qt.Key_Down) {
+                                viewStack.focus = true;
+                                event.accepted = true;
+                            } else if (event.key === Qt.Key_Enter || event.key === Qt.Key_Return) {
+                                viewStack.currentItem.activateCurrentItem();
+                                event.accepted = true;
+                            }
+                        }
+                    }
+
+                    PlasmaComponents.ToolButton {
+                        id: folderScopeButton
+
+                        readonly property string folderName: viewStack.filterMode ? viewStack.searchFolderName : currentPath.text
+
+                        visible: viewStack.filterMode ? viewStack.searchFolder !== null : viewStack.depth > 1
+                        checkable: true
+                        icon.name: "folder-symbolic"
+                        display: QQC2.AbstractButton.IconOnly
+                        text: i18n("Search only in %1", folderName)
+
+                        PlasmaComponents.ToolTip {
+                            text: folderScopeButton.text
+                        }
+                    }
+
+                    PlasmaComponents.ToolButton {
+                        id: otpDashboardButton
+
+                        visible: !viewStack.filterMode && viewStack.currentItem instanceof PasswordsPage
+                        icon.name: "clock-symbolic"
+                        display: QQC2.AbstractButton.IconOnly
+                        text: currentPath.text === "" ? i18n("Show OTP codes") : i18n("Show OTP codes in %1", currentPath.text)
+                        onClicked: viewStack.pushOtpDashboard()
+
+                        PlasmaComponents.ToolTip {
+                            text: otpDashboardButton.text
+                        }
+                    }
 
-                    placeholderText: i18n("Filter...")
-                    clearButtonShown: true
+                    PlasmaComponents.ToolButton {
+                        id: auditButton
 
-                    Layout.fillWidth: true
+                        visible: !viewStack.filterMode && !(viewStack.currentItem instanceof AuditPage)
+                        icon.name: "security-medium-symbolic"
+                        display: QQC2.AbstractButton.IconOnly
+                        text: currentPath.text === "" ? i18n("Check passwords") : i18n("Check passwords in %1", currentPath.text)
+                        onClicked: viewStack.pushAudit()
 
-                    Keys.priority: Keys.BeforeItem
-                    Keys.onPressed: event=> {
-                        if (event.key == Qt.Key_Down) {
-                            viewStack.focus = true;
-                            event.accepted = true;
-                        } else if (event.key === Qt.Key_Enter || event.key === Qt.Key_Return) {
-                            viewStack.currentItem.activateCurrentItem();
-                            event.accepted = true;
+                        PlasmaComponents.ToolTip {
+                            text: auditButton.text
                         }
                     }
                 }
@@ -155,6 +235,9 @@ PlasmoidItem {
             anchors.fill: parent
 
             readonly property bool filterMode: filterField.text !== ""
+            // Folder the user was in when they started filtering, the search can be limited to it
+            property var searchFolder: null
+            property string searchFolderName
 
             onCurrentItemChanged: {
                 if (currentItem) {
@@ -164,7 +247,12 @@ PlasmoidItem {
             }
 
             onFilterModeChanged: {
+                if (filterMode) {
+                    searchFolder = depth > 1 ? currentItem.rootIndex : null;
+                    searchFolderName = currentPath.text;
+                }
                 pop(null);
+                currentPath.clearName();
                 if (filterMode) {
                     pushItem(filterPage, { rootIndex: null, stack: viewStack });
                 }
@@ -178,6 +266,20 @@ PlasmoidItem {
                 currentPath.pushName(name);
             }
 
+            function pushAudit() {
+                // A running audit keeps its folder, the page shows its progress
+                if (!passwordAudit.running) {
+                    passwordAudit.folder = currentPath.text;
+                }
+                pushItem(auditPage, { stack: viewStack });
+                currentPath.pushName(i18n("Check passwords"));
+            }
+
+            function pushOtpDashboard() {
+                pushItem(otpDashboardPage, { stack: viewStack, folder: currentPath.text });
+                currentPath.pushName(i18n("OTP codes"));
+            }
+
             function popPage() {
                 pop();
                 currentPath.popName();
@@ -6,29 +6,141 @@
 
 #include <QVarLengthArray>
 
+#include <algorithm>
+
 namespace
 {
 constexpr const std::size_t offsetsSize = 32;
 constexpr const int maxDepth = 128;
 
+// Positions of the matched characters within a word
+using MatchPositions = QVarLengthArray<int, offsetsSize>;
+
+void recordPosition(MatchPositions *positions, int position)
+{
+    if (positions != nullptr) {
+        positions->push_back(position);
+    }
+}
+
+void addRange(PlasmaPass::MatchRanges *ranges, qsizetype start, qsizetype length)
+{
+    if (ranges != nullptr && length > 0 && start + length <= 0xFFFF) {
+        ranges->push_back(static_cast<quint32>(start) << 16 | static_cast<quint32>(length));
+    }
+}
+
+void addPositions(PlasmaPass::MatchRanges *ranges, qsizetype offset, const MatchPositions &positions)
+{
+    for (const int position : positions) {
+        addRange(ranges, offset + position, 1);
+    }
+}
+
+// Sorts the ranges and merges those that touch
+void normalizeRanges(PlasmaPass::MatchRanges &ranges)
+{
+    std::sort(ranges.begin(), ranges.end());
+    qsizetype out = 0;
+    for (qsizetype i = 0; i < ranges.size(); ++i) {
+        if (out > 0) {
+            auto &last = ranges[out - 1];
+            const quint32 lastEnd = (last >> 16) + (last & 0xFFFF);
+            const quint32 start = ranges[i] >> 16;
+            if (start <= lastEnd) {
+                const quint32 end = std::max(lastEnd, start + (ranges[i] & 0xFFFF));
+                last = (last & 0xFFFF0000) | (end - (last >> 16));
+                continue;
+            }
+        }
+        ranges[out++] = ranges[i];
+    }
+    ranges.resize(out);
+}
+
+// Case mapping of Latin-1 characters, taken from QChar so that both instantiations
+// of the matchers below give identical results.
+struct Latin1Tables {
+    Latin1Tables()
+    {
+        for (int c = 0; c < 256; ++c) {
+            const QChar ch(static_cast<char16_t>(c));
+            lower[c] = static_cast<uchar>(ch.toLower().unicode());
+            upper[c] = ch.isUpper();
+        }
+    }
+
+    std::array<uchar, 256> lower = {};
+    std::array<bool, 256> upper = {};
+};
+
+const Latin1Tables latin1Tables;
+
+struct Utf16Traits {
+    using View = QStringView;
+    using Char = QChar;
+
+    static QChar at(View view, qsizetype i)
+    {
+        return view.at(i);
+    }
+    static QChar toLower(QChar c)
+    {
+        return c.toLower();
+    }
+    static bool isUpper(QChar c)
+    {
+        return c.isUpper();
+    }
+    static bool isSeparator(QChar c)
+    {
+        return c == QLatin1Char('_') || c == QLatin1Char('-');
+    }
+};
+
+struct Latin1Traits {
+    using View = QLatin1StringView;
+    using Char = uchar;
+
+    static uchar at(View view, qsizetype i)
+    {
+        return static_cast<uchar>(view.data()[i]);
+    }
+    static uchar toLower(uchar c)
+    {
+        return latin1Tables.lower[c];
+    }
+    static bool isUpper(uchar c)
+    {
+        return latin1Tables.upper[c];
+    }
+    static bool isSeparator(uchar c)
+    {
+        return c == '_' || c == '-';
+    }
+};
+
 // Taken and adapted for kdevelop from katecompletionmodel.cpp
-bool matchesAbbreviationHelper(const QStringView &word,
-                               const QStringView &typed,
+template<typename Traits>
+bool matchesAbbreviationHelper(typename Traits::View word,
+                               typename Traits::View typed,
                                const QVarLengthArray<int, offsetsSize> &offsets,
                                int &depth,
+                               MatchPositions *positions,
                                int atWord = -1,
                                int i = 0)
 
 {
     int atLetter = 1;
     for (; i < typed.size(); i++) {
-        const QChar c = typed.at(i).toLower();
+        const auto c = Traits::toLower(Traits::at(typed, i));
         bool haveNextWord = offsets.size() > atWord + 1;
         bool canCompare = atWord != -1 && word.size() > offsets.at(atWord) + atLetter;
-        if (canCompare && c == word.at(offsets.at(atWord) + atLetter).toLower()) {
+        if (canCompare && c == Traits::toLower(Traits::at(word, offsets.at(atWord) + atLetter))) {
             // the typed letter matches a letter after the current word beginning
-            if (!haveNextWord || c != word.at(offsets.at(atWord + 1)).toLower()) {
+            if (!haveNextWord || c != Traits::toLower(Traits::at(word, offsets.at(atWord + 1)))) {
                 // good, simple case, no conflict
+                recordPosition(positions, offsets.at(atWord) + atLetter);
                 atLetter += 1;
                 continue;
             }
@@ -40,17 +152,24 @@ bool matchesAbbreviationHelper(const QStringView &word,
                 return false;
             }
             // the letter matches both the next word beginning and the next character in the word
-            if (haveNextWord && matchesAbbreviationHelper(word, typed, offsets, depth, atWord + 1, i + 1)) {
+            const auto recorded = positions != nullptr ? positions->size() : 0;
+            recordPosition(positions, offsets.at(atWord + 1));
+            if (haveNextWord && matchesAbbreviationHelper<Traits>(word, typed, offsets, depth, positions, atWord + 1, i + 1)) {
                 // resolving the conflict by taking the next word's first character worked, fine
                 return true;
             }
+            if (positions != nullptr) {
+                positions->resize(recorded);
+            }
             // otherwise, continue by taking the next letter in the current word.
+            recordPosition(positions, offsets.at(atWord) + atLetter);
             atLetter += 1;
             continue;
         }
 
-        if (haveNextWord && c == word.at(offsets.at(atWord + 1)).toLower()) {
+        if (haveNextWord && c == Traits::toLower(Traits::at(word, offsets.at(atWord + 1)))) {
             // the typed letter matches the next word beginning
+            recordPosition(positions, offsets.at(atWord + 1));
             atWord++;
             atLetter = 1;
             continue;
@@ -63,19 +182,20 @@ bool matchesAbbreviationHelper(const QStringView &word,
     return true;
 }
 
-}
-bool PlasmaPass::matchesAbbreviation(const QStringView &word, const QStringView &typed)
+template<typename Traits>
+bool matchesAbbreviationImpl(typename Traits::View word, typename Traits::View typed, MatchPositions *positions = nullptr)
 {
     // A mismatch is very likely for random even for the first letter,
     // thus this optimization makes sense.
-    if (word.at(0).toLower() != typed.at(0).toLower()) {
+    if (Traits::toLower(Traits::at(word, 0)) != Traits::toLower(Traits::at(typed, 0))) {
         return false;
     }
 
     // First, check if all letters are contained in the word in the right order.
     int atLetter = 0;
-    for (const auto c : typed) {
-        while (c.toLower() != word.at(atLetter).toLower()) {
+    for (qsizetype i = 0; i < typed.size(); ++i) {
+        const auto c = Traits::toLower(Traits::at(typed, i));
+        while (c != Traits::toLower(Traits::at(word, atLetter))) {
             atLetter += 1;
             if (atLetter >= word.size()) {
                 return false;
@@ -92,32 +212,37 @@ bool PlasmaPass::matchesAbbreviation(const QStringView &word, const QStringView
     // the following abbreviation, so we need to find all possible word offsets first,
     // then compare.
     for (int i = 0; i < word.size(); ++i) {
-        const QChar c = word.at(i);
-        if (c == QLatin1Char('_') || c == QLatin1Char('-')) {
+        const auto c = Traits::at(word, i);
+        if (Traits::isSeparator(c)) {
             haveUnderscore = true;
-        } else if (haveUnderscore || c.isUpper()) {
+        } else if (haveUnderscore || Traits::isUpper(c)) {
             offsets.append(i);
             haveUnderscore = false;
         }
     }
     int depth = 0;
-    return matchesAbbreviationHelper(word, typed, offsets, depth);
+    return matchesAbbreviationHelper<Traits>(word, typed, offsets, depth, positions);
 }
-bool PlasmaPass::matchesPath(const QStringView &path, const QStringView &typed)
+
+template<typename Traits>
+bool matchesPathImpl(typename Traits::View path, typename Traits::View typed, MatchPositions *positions = nullptr)
 {
     int consumed = 0;
     int pos = 0;
     // try to find all the characters in typed in the right order in the path;
     // jumps are allowed everywhere
     while (consumed < typed.size() && pos < path.size()) {
-        if (typed.at(consumed).toLower() == path.at(pos).toLower()) {
+        if (Traits::toLower(Traits::at(typed, consumed)) == Traits::toLower(Traits::at(path, pos))) {
+            recordPosition(positions, pos);
             consumed++;
         }
         pos++;
     }
     return consumed == typed.size();
 }
-int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVector<QStringView> &text)
+
+template<typename Traits>
+int matchPathFilterImpl(const QVector<typename Traits::View> &toFilter, const QVector<typename Traits::View> &text, PlasmaPass::MatchRanges *ranges)
 {
     enum PathFilterMatchQuality {
         NoMatch = -1,
@@ -132,6 +257,12 @@ int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVec
         return NoMatch;
     }
 
+    if (ranges != nullptr) {
+        ranges->clear();
+    }
+    MatchPositions positions;
+    MatchPositions *positionsPtr = ranges != nullptr ? &positions : nullptr;
+
     bool allMatched = true;
     int searchIndex = text.size() - 1;
     int pathIndex = segments.size() - 1;
@@ -149,11 +280,12 @@ int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVec
 
         // check for fuzzy matches
         bool isMatch = matchIndex != -1;
+        positions.clear();
         // do fuzzy path matching on the last segment
         if (!isMatch && isLastPathSegment && isLastSearchSegment) {
-            isMatch = matchesPath(segment, typedSegment);
+            isMatch = matchesPathImpl<Traits>(segment, typedSegment, positionsPtr);
         } else if (!isMatch) { // check other segments for abbreviations
-            isMatch = matchesAbbreviation(segment.mid(0), typedSegment);
+            isMatch = matchesAbbreviationImpl<Traits>(segment, typedSegment, positionsPtr);
         }
 
         if (!isMatch) {
@@ -161,6 +293,15 @@ int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVec
             --pathIndex;
             continue;
         }
+        if (ranges != nullptr) {
+            // The segments are views into the same path, so this is where the segment starts in it
+            const qsizetype segmentOffset = segment.data() - segments.first().data();
+            if (matchIndex != -1) {
+                addRange(ranges, segmentOffset + matchIndex, typedSegment.size());
+            } else {
+                addPositions(ranges, segmentOffset, positions);
+            }
+        }
         // else we matched
         if (isLastPathSegment) {
             lastMatchIndex = matchIndex;
@@ -170,8 +311,14 @@ int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVec
     }
 
     if (searchIndex != -1) {
+        if (ranges != nullptr) {
+            ranges->clear();
+        }
         return NoMatch;
     }
+    if (ranges != nullptr) {
+        normalizeRanges(*ranges);
+    }
 
     const int segmentMatchDistance = segments.size() - (pathIndex + 1);
 
@@ -187,3 +334,239 @@ int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVec
     // prefer matches closer to the end of the path
     return OtherMatch + segmentMatchDistance;
 }
+
+}
+
+bool PlasmaPass::matchesAbbreviation(const QStringView &word, const QStringView &typed)
+{
+    return matchesAbbreviationImpl<Utf16Traits>(word, typed);
+}
+
+bool PlasmaPass::matchesAbbreviation(QLatin1StringView word, QLatin1StringView typed)
+{
+    return matchesAbbreviationImpl<Latin1Traits>(word, typed);
+}
+
+bool PlasmaPass::matchesPath(const QStringView &path, const QStringView &typed)
+{
+    return matchesPathImpl<Utf16Traits>(path, typed);
+}
+
+bool PlasmaPass::matchesPath(QLatin1StringView path, QLatin1StringView typed)
+{
+    return matchesPathImpl<Latin1Traits>(path, typed);
+}
+
+int PlasmaPass::matchPathFilter(const QVector<QStringView> &toFilter, const QVector<QStringView> &text, MatchRanges *ranges)
+{
+    return matchPathFilterImpl<Utf16Traits>(toFilter, text, ranges);
+}
+
+int PlasmaPass::matchPathFilter(const QVector<QLatin1StringView> &toFilter, const QVector<QLatin1StringView> &text, MatchRanges *ranges)
+{
+    return matchPathFilterImpl<Latin1Traits>(toFilter, text, ranges);
+}
+
+bool PlasmaPass::isLatin1(QStringView string)
+{
+    return std::all_of(string.cbegin(), string.cend(), [](QChar c) {
+        return c.unicode() < 256;
+    });
+}
+
+QVector<QLatin1StringView> PlasmaPass::splitPath(QLatin1StringView path, Qt::SplitBehavior behavior)
+{
+    QVector<QLatin1StringView> segments;
+    qsizetype start = 0;
+    while (start <= path.size()) {
+        qsizetype end = path.indexOf(QLatin1Char('/'), start);
+        if (end == -1) {
+            end = path.size();
+        }
+        if (end > start || behavior == Qt::KeepEmptyParts) {
+            segments.push_back(path.sliced(start, end - start));
+        }
+        start = end + 1;
+    }
+    return segments;
+}
+
+QString PlasmaPass::normalizeForMatching(const QString &text, QList<int> *positions)
+{
+    if (positions != nullptr) {
+        positions->clear();
+    }
+    // Nothing to decompose in plain ASCII, which is what most names are
+    if (std::all_of(text.cbegin(), text.cend(), [](QChar c) {
+            return c.unicode() < 128;
+        })) {
+        return text;
+    }
+
+    QString result;
+    result.reserve(text.size());
+    QList<int> map;
+    map.reserve(text.size() + 1);
+    for (qsizetype i = 0; i < text.size();) {
+        const qsizetype length = text.at(i).isHighSurrogate() && i + 1 < text.size() && text.at(i + 1).isLowSurrogate() ? 2 : 1;
+        const auto character = text.sliced(i, length);
+        // Decomposing character by character gives the same result as decomposing the
+        // whole text, NFKD only reorders the marks, which are dropped anyway
+        const auto decomposed = character.at(0).unicode() < 128 ? character : character.normalized(QString::NormalizationForm_KD);
+        for (qsizetype j = 0; j < decomposed.size();) {
+            const qsizetype decomposedLength = decomposed.at(j).isHighSurrogate() && j + 1 < decomposed.size() ? 2 : 1;
+            const auto category = QChar::category(decomposedLength == 2 ? QChar::surrogateToUcs4(decomposed.at(j), decomposed.at(j + 1)) : decomposed.at(j).unicode());
+            if (category != QChar::Mark_NonSpacing && category != QChar::Mark_SpacingCombining && category != QChar::Mark_Enclosing) {
+                result.append(decomposed.sliced(j, decomposedLength));
+                for (qsizetype k = 0; k < decomposedLength; ++k) {
+                    map.push_back(static_cast<int>(i));
+                }
+            }
+            j += decomposedLength;
+        }
+        i += length;
+    }
+
+    if (positions != nullptr) {
+        bool identity = result.size() == text.size();
+        for (qsizetype i = 0; identity && i < map.size(); ++i) {
+            identity = map.at(i) == i;
+        }
+        if (!identity) {
+            map.push_back(static_cast<int>(text.size()));
+            *positions = std::move(map);
+        }
+    }
+    return result;
+}
+
+void PlasmaPass::mapRanges(MatchRanges &ranges, const QList<int> &positions)
+{
+    if (positions.isEmpty()) {
+        return;
+    }
+
+    for (auto &range : ranges) {
+        const auto start = static_cast<qsizetype>(range >> 16);
+        const auto end = start + static_cast<qsizetype>(range & 0xFFFF);
+        // The range ends where the next character of the original text starts, so it covers
+        // the marks that were removed and the whole character when only a part of its
+        // decomposition matched
+        auto next = end;
+        while (positions.at(next) == positions.at(end - 1)) {
+            ++next;
+        }
+        const auto originalStart = static_cast<quint32>(positions.at(start));
+        range = originalStart << 16 | (static_cast<quint32>(positions.at(next)) - originalStart);
+    }
+    // Parts of the same character may have been matched by different ranges
+    normalizeRanges(ranges);
+}
+
+PlasmaPass::FuzzyMatcher::FuzzyMatcher(QStringView pattern, int maxErrors)
+{
+    if (pattern.isEmpty() || pattern.size() > MaxPatternLength || maxErrors < 0) {
+        return;
+    }
+
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const char16_t c = pattern.at(i).unicode();
+        const quint64 bit = quint64(1) << i;
+        if (c < mLatin1Masks.size()) {
+            mLatin1Masks[c] |= bit;
+            continue;
+        }
+
+        auto it = std::find_if(mOtherMasks.begin(), mOtherMasks.end(), [c](const auto &mask) {
+            return mask.first == c;
+        });
+        if (it == mOtherMasks.end()) {
+            mOtherMasks.append({c, bit});
+        } else {
+            it->second |= bit;
+        }
+    }
+
+    mMatchBit = quint64(1) << (pattern.size() - 1);
+    mMaxErrors = std::min(maxErrors, MaxErrors);
+}
+
+int PlasmaPass::FuzzyMatcher::errorsForLength(qsizetype length)
+{
+    // Short queries are too ambiguous to tolerate any typos
+    if (length < 4) {
+        return 0;
+    }
+    if (length < 8) {
+        return 1;
+    }
+    return MaxErrors;
+}
+
+bool PlasmaPass::FuzzyMatcher::isValid() const
+{
+    return mMaxErrors >= 0;
+}
+
+quint64 PlasmaPass::FuzzyMatcher::mask(QChar c) const
+{
+    const char16_t u = c.unicode();
+    if (u < mLatin1Masks.size()) {
+        return mLatin1Masks[u];
+    }
+    for (const auto &mask : mOtherMasks) {
+        if (mask.first == u) {
+            return mask.second;
+        }
+    }
+    return 0;
+}
+
+int PlasmaPass::FuzzyMatcher::match(QStringView text) const
+{
+    if (!isValid()) {
+        return -1;
+    }
+    if (text.size() > MaxTextLength) {
+        text = text.last(MaxTextLength);
+    }
+
+    // Bit i of state[d] is set when the first i + 1 characters of the pattern match
+    // a substring ending at the current text position with at most d errors.
+    std::array<quint64, MaxErrors + 1> state = {};
+    for (int d = 0; d <= mMaxErrors; ++d) {
+        // the first d characters of the pattern can always be deleted
+        state[d] = (quint64(1) << d) - 1;
+    }
+    auto prevState = state; // the state two characters back, for transpositions
+    quint64 prevMask = 0;
+
+    int best = -1;
+    for (const auto c : text) {
+        const quint64 m = mask(c);
+        const auto old = state;
+
+        state[0] = ((old[0] << 1) | 1) & m;
+        for (int d = 1; d <= mMaxErrors; ++d) {
+            state[d] = (((old[d] << 1) | 1) & m) // match
+                | old[d - 1] // insertion
+                | ((old[d - 1] << 1) | 1) // substitution
+                | ((state[d - 1] << 1) | 1) // deletion
+                | (((((prevState[d - 1] << 1) | 1) << 1) & (m << 1)) & prevMask); // transposition
+        }
+        prevState = old;
+        prevMask = m;
+
+        for (int d = 0; d <= mMaxErrors && (best == -1 || d < best); ++d) {
+            if ((state[d] & mMatchBit) != 0) {
+                best = d;
+                break;
+            }
+        }
+        if (best == 0) {
+            break;
+        }
+    }
+
+    return best;
+}
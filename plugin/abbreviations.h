@@ -6,20 +6,122 @@
 #define PLASMAPASS_ABBREVIATIONS_H
 
 #include <QStringList>
+#include <QVarLengthArray>
 #include <QVector>
+
+#include <array>
+
 class QString;
 
 namespace PlasmaPass
 {
 bool matchesAbbreviation(const QStringView &word, const QStringView &typed);
+bool matchesAbbreviation(QLatin1StringView word, QLatin1StringView typed);
 
 bool matchesPath(const QStringView &path, const QStringView &typed);
+bool matchesPath(QLatin1StringView path, QLatin1StringView typed);
+
+/**
+ * @brief Character ranges of a path that matched the search fragments.
+ *
+ * Each range is packed as start << 16 | length, the ranges are sorted and do not overlap.
+ */
+using MatchRanges = QVarLengthArray<quint32, 8>;
 
 /**
  * @brief Matches a path against a list of search fragments.
  * @return -1 when no match is found, otherwise a positive integer, higher values mean lower quality
+ *
+ * When @p ranges is given, it is filled with the matched characters of the path as part
+ * of the same pass. It is left empty when there is no match.
+ *
+ * The Latin-1 overloads give the same results as the UTF-16 ones, but work on 8-bit
+ * strings with table-driven case mapping. They can be used when both the path and the
+ * search fragments consist only of Latin-1 characters, see isLatin1().
+ */
+int matchPathFilter(const QVector<QStringView> &toFilter, const QVector<QStringView> &text, MatchRanges *ranges = nullptr);
+int matchPathFilter(const QVector<QLatin1StringView> &toFilter, const QVector<QLatin1StringView> &text, MatchRanges *ranges = nullptr);
+
+/**
+ * @brief Whether all characters of @p string can be represented in Latin-1.
+ */
+bool isLatin1(QStringView string);
+
+/**
+ * @brief Splits a Latin-1 path into its segments, like QStringView::split() does.
+ */
+QVector<QLatin1StringView> splitPath(QLatin1StringView path, Qt::SplitBehavior behavior = Qt::KeepEmptyParts);
+
+/**
+ * @brief Returns @p text with compatibility decomposition (NFKD) applied and all combining marks removed.
+ *
+ * This makes "Bücherei" match "bucherei" and full-width letters match their ASCII
+ * counterparts. The case is preserved, so the result can be passed to matchPathFilter().
+ *
+ * When @p positions is given and the characters of the result do not correspond one to
+ * one to those of @p text, it receives the position in @p text of each character of
+ * the result, followed by the length of @p text. Otherwise it is cleared. See mapRanges().
+ */
+QString normalizeForMatching(const QString &text, QList<int> *positions = nullptr);
+
+/**
+ * @brief Maps ranges matched in a string returned by normalizeForMatching() back to the original text.
+ */
+void mapRanges(MatchRanges &ranges, const QList<int> &positions);
+
+/**
+ * @brief Quality of a typo-tolerant match without any errors, see FuzzyMatcher.
+ *
+ * It is worse than any quality returned by matchPathFilter(), each edit needed
+ * to make the match adds one to it.
+ */
+constexpr const int FuzzyMatchQuality = 1 << 16;
+
+/**
+ * @brief Typo-tolerant substring matcher.
+ *
+ * Finds whether the pattern occurs anywhere in a text with at most a given number of
+ * edits (insertions, deletions, substitutions or transpositions of two adjacent letters).
+ * It uses the bit-parallel bitap algorithm (Wu-Manber, with Hyyrö's transpositions), so
+ * the cost of a match is linear in the length of the text and in the number of allowed
+ * errors, independently of the content. Both the pattern and the texts are expected to
+ * be case-folded by the caller.
  */
-int matchPathFilter(const QVector<QStringView> &toFilter, const QVector<QStringView> &text);
+class FuzzyMatcher
+{
+public:
+    static constexpr const int MaxPatternLength = 64;
+    static constexpr const int MaxErrors = 2;
+    // Only the tail of longer texts is considered, to keep the cost per entry bounded
+    static constexpr const int MaxTextLength = 128;
+
+    explicit FuzzyMatcher() = default;
+    FuzzyMatcher(QStringView pattern, int maxErrors);
+
+    /**
+     * @brief Returns the number of errors appropriate for a pattern of given length.
+     */
+    static int errorsForLength(qsizetype length);
+
+    /**
+     * @brief Whether the matcher can match anything at all.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Matches the pattern against @p text.
+     * @return -1 when no match is found, otherwise the smallest number of edits needed.
+     */
+    int match(QStringView text) const;
+
+private:
+    quint64 mask(QChar c) const;
+
+    std::array<quint64, 256> mLatin1Masks = {};
+    QVarLengthArray<std::pair<char16_t, quint64>, 8> mOtherMasks;
+    quint64 mMatchBit = 0;
+    int mMaxErrors = -1;
+};
 }
 
 #endif
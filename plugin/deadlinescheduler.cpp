@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "deadlinescheduler.h"
+
+#include <QCoreApplication>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using namespace PlasmaPass;
+
+DeadlineScheduler *DeadlineScheduler::instance()
+{
+    static QPointer<DeadlineScheduler> sInstance;
+    if (sInstance.isNull()) {
+        sInstance = new DeadlineScheduler(QCoreApplication::instance());
+    }
+    return sInstance;
+}
+
+DeadlineScheduler::DeadlineScheduler(QObject *parent)
+    : QObject(parent)
+{
+    mTimer.setSingleShot(true);
+    // Secrets should not stay in the clipboard for longer than promised
+    mTimer.setTimerType(Qt::PreciseTimer);
+    connect(&mTimer, &QTimer::timeout, this, &DeadlineScheduler::fire);
+}
+
+DeadlineScheduler::~DeadlineScheduler() = default;
+
+DeadlineScheduler::Id DeadlineScheduler::schedule(QDeadlineTimer deadline, QObject *context, std::function<void()> callback)
+{
+    const auto id = ++mNextId;
+    mIds.insert(id, mDeadlines.emplace(deadline.deadline(), Deadline{id, context, std::move(callback)}));
+    // Re-arm only when the new deadline is the nearest one
+    if (mDeadlines.begin()->second.id == id) {
+        arm();
+    }
+    return id;
+}
+
+void DeadlineScheduler::cancel(Id id)
+{
+    const auto it = mIds.constFind(id);
+    if (it == mIds.cend()) {
+        mDue.remove(id);
+        return;
+    }
+
+    const bool nearest = *it == mDeadlines.begin();
+    mDeadlines.erase(*it);
+    mIds.erase(it);
+    if (nearest) {
+        arm();
+    }
+}
+
+void DeadlineScheduler::arm()
+{
+    if (mDeadlines.empty()) {
+        mTimer.stop();
+        return;
+    }
+
+    const auto remaining = mDeadlines.begin()->first - QDeadlineTimer::current().deadline();
+    mTimer.start(static_cast<int>(std::clamp<qint64>(remaining, 0, std::numeric_limits<int>::max())));
+}
+
+void DeadlineScheduler::fire()
+{
+    // Take out all that are due first, the callbacks may schedule or cancel other deadlines
+    const auto now = QDeadlineTimer::current().deadline();
+    std::vector<Deadline> due;
+    while (!mDeadlines.empty() && mDeadlines.begin()->first <= now) {
+        auto node = mDeadlines.extract(mDeadlines.begin());
+        mIds.remove(node.mapped().id);
+        mDue.insert(node.mapped().id);
+        due.push_back(std::move(node.mapped()));
+    }
+
+    for (const auto &deadline : due) {
+        // An earlier callback may have canceled it
+        if (mDue.remove(deadline.id) && !deadline.context.isNull()) {
+            deadline.callback();
+        }
+    }
+
+    arm();
+}
+
+#include "moc_deadlinescheduler.cpp"
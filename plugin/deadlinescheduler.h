@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef DEADLINESCHEDULER_H_
+#define DEADLINESCHEDULER_H_
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+
+#include <functional>
+#include <map>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Calls back when deadlines pass, all of them driven by a single timer.
+ *
+ * Instead of each provider ticking its own timer to count down, they all register
+ * their deadlines here. The timer is armed only for the nearest deadline, so the
+ * process does not wake up at all between two deadlines.
+ */
+class DeadlineScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    using Id = quint64;
+
+    static DeadlineScheduler *instance();
+
+    ~DeadlineScheduler() override;
+
+    /**
+     * @brief Calls @p callback once @p deadline has passed, unless @p context is destroyed by then.
+     *
+     * @return identifier of the deadline for cancel(), never 0
+     */
+    Id schedule(QDeadlineTimer deadline, QObject *context, std::function<void()> callback);
+
+    /**
+     * @brief Drops the deadline without calling it back.
+     *
+     * Works also for deadlines that passed together with the one being called back.
+     * Does nothing for 0 or deadlines that have been called back already.
+     */
+    void cancel(Id id);
+
+private:
+    explicit DeadlineScheduler(QObject *parent = nullptr);
+
+    void arm();
+    void fire();
+
+    struct Deadline {
+        Id id = 0;
+        QPointer<QObject> context;
+        std::function<void()> callback;
+    };
+    using Deadlines = std::multimap<qint64, Deadline>;
+
+    // By the deadline in msecs of the monotonic clock (see QDeadlineTimer::deadline())
+    Deadlines mDeadlines;
+    QHash<Id, Deadlines::iterator> mIds;
+    // Deadlines taken out by fire() that have not been called back yet
+    QSet<Id> mDue;
+    QTimer mTimer;
+    Id mNextId = 0;
+};
+
+}
+
+#endif // DEADLINESCHEDULER_H_
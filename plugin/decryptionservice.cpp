@@ -0,0 +1,597 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "decryptionservice.h"
+#include "passwordsmodel.h"
+#include "plasmapass_debug.h"
+
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QStringDecoder>
+#include <QTimer>
+
+#include <KLocalizedString>
+
+#include <gpgme++/context.h>
+#include <gpgme++/data.h>
+#include <gpgme++/decryptionresult.h>
+#include <gpgme++/global.h>
+#include <gpgme++/key.h>
+#include <gpgme++/interfaces/dataprovider.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+using namespace PlasmaPass;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Decryptions running at the same time, gpg-agent asks for one passphrase at a time anyway
+constexpr const int maxConcurrentDecryptions = 2;
+// The plain text of password files up to this size is always kept whole, see Job::readToEnd()
+constexpr const qint64 smallFileSize = 64 * 1024;
+// The agent keeps the keys for a while, no need to warm up every time the popup opens
+constexpr const auto warmUpInterval = 5min;
+
+// Each worker creates its context once and reuses it for all of its decryptions
+GpgME::Context *workerContext()
+{
+    thread_local std::unique_ptr<GpgME::Context> context;
+    if (context == nullptr) {
+        context = GpgME::Context::create(GpgME::OpenPGP);
+    }
+    return context.get();
+}
+}
+
+// Receives the plain text from the worker thread and posts its complete lines to the service
+class DecryptionService::Job : public GpgME::DataProvider
+{
+public:
+    Job(DecryptionService *service, QString path, quint64 id)
+        : mService(service)
+        , mPath(std::move(path))
+        , mId(id)
+    {
+    }
+
+    bool isSupported(Operation operation) const override
+    {
+        return operation == Write;
+    }
+
+    ssize_t read(void *buffer, size_t bufferSize) override
+    {
+        Q_UNUSED(buffer)
+        Q_UNUSED(bufferSize)
+        errno = EBADF;
+        return -1;
+    }
+
+    ssize_t write(const void *buffer, size_t bufferSize) override
+    {
+        // Fails the decryption, in case it did not notice it has been canceled
+        if (mStopped.loadRelaxed()) {
+            errno = ECANCELED;
+            return -1;
+        }
+
+        mWritten = mWritten || bufferSize > 0;
+        // Only decrypted to the end for the integrity check, nobody needs the plain text
+        if (mDiscard.loadRelaxed()) {
+            mBuffer.clear();
+            return static_cast<ssize_t>(bufferSize);
+        }
+        mBuffer.appendUtf8(mDecoder, QByteArrayView(static_cast<const char *>(buffer), static_cast<qsizetype>(bufferSize)));
+        const auto lastNewline = mBuffer.view().lastIndexOf(QLatin1Char('\n'));
+        if (lastNewline != -1) {
+            // The complete lines go to the service, the incomplete last one stays here. The
+            // service hands the buffers back, so that not every write maps new memory.
+            auto lines = spare();
+            std::swap(*lines, mBuffer);
+            mBuffer.append(lines->view().sliced(lastNewline + 1));
+            lines->truncate(lastNewline + 1);
+            QMetaObject::invokeMethod(
+                mService,
+                [service = mService, path = mPath, id = mId, lines]() {
+                    service->addLines(path, id, lines);
+                },
+                Qt::QueuedConnection);
+        }
+        return static_cast<ssize_t>(bufferSize);
+    }
+
+    off_t seek(off_t offset, int whence) override
+    {
+        Q_UNUSED(offset)
+        Q_UNUSED(whence)
+        errno = ESPIPE;
+        return -1;
+    }
+
+    void release() override
+    {
+    }
+
+    // Called by the worker around the decryption, returns false when the job has been canceled already
+    bool begin(GpgME::Context *context, qint64 fileSize)
+    {
+        QMutexLocker lock(&mMutex);
+        mReadToEnd.storeRelaxed(fileSize <= smallFileSize);
+        mContext = context;
+        return !mStopped.loadRelaxed();
+    }
+    void end()
+    {
+        QMutexLocker lock(&mMutex);
+        mContext = nullptr;
+    }
+
+    void cancel()
+    {
+        QMutexLocker lock(&mMutex);
+        mStopped.storeRelaxed(true);
+        if (mContext != nullptr) {
+            mContext->cancelPendingOperation();
+        }
+    }
+
+    // The plain text of small files is kept even when nobody needs the rest of the lines,
+    // it costs next to nothing and the entry can be shared afterwards
+    bool readToEnd() const
+    {
+        return mReadToEnd.loadRelaxed();
+    }
+
+    // The rest of the plain text is thrown away by the worker as it comes
+    void discardOutput()
+    {
+        mDiscard.storeRelaxed(true);
+    }
+
+    // Takes back a buffer of lines the service has copied, for the next write
+    void recycle(std::shared_ptr<SecretBuffer> buffer)
+    {
+        buffer->truncate(0);
+        QMutexLocker lock(&mMutex);
+        mSpare.push_back(std::move(buffer));
+    }
+
+    // Both only valid once the decryption has finished
+    bool isEmpty() const
+    {
+        return !mWritten;
+    }
+    QStringView remainder() const
+    {
+        return mBuffer.view();
+    }
+
+private:
+    std::shared_ptr<SecretBuffer> spare()
+    {
+        QMutexLocker lock(&mMutex);
+        if (mSpare.empty()) {
+            return std::make_shared<SecretBuffer>();
+        }
+        auto buffer = std::move(mSpare.back());
+        mSpare.pop_back();
+        return buffer;
+    }
+
+    DecryptionService *const mService;
+    const QString mPath;
+    const quint64 mId;
+    SecretBuffer mBuffer; // incomplete last line
+    QStringDecoder mDecoder{QStringDecoder::Utf8};
+    bool mWritten = false;
+    QAtomicInteger<bool> mStopped = false;
+    QAtomicInteger<bool> mReadToEnd = true;
+    QAtomicInteger<bool> mDiscard = false;
+    QMutex mMutex;
+    GpgME::Context *mContext = nullptr;
+    std::vector<std::shared_ptr<SecretBuffer>> mSpare; // wiped, but still mapped
+};
+
+DecryptionService *DecryptionService::instance()
+{
+    static QPointer<DecryptionService> sInstance;
+    if (sInstance.isNull()) {
+        sInstance = new DecryptionService(QCoreApplication::instance());
+    }
+    return sInstance;
+}
+
+DecryptionService::DecryptionService(QObject *parent)
+    : QObject(parent)
+{
+    GpgME::initializeLibrary();
+
+    mPool.setMaxThreadCount(maxConcurrentDecryptions);
+    // Keep the threads, and with them their GPGME contexts, around between decryptions
+    mPool.setExpiryTimeout(-1);
+}
+
+DecryptionService::~DecryptionService()
+{
+    // The pool waits for the workers, don't let them wait for a passphrase
+    for (const auto &decryption : std::as_const(mDecryptions)) {
+        if (decryption.started) {
+            decryption.job->cancel();
+        }
+    }
+    for (const auto &decryption : std::as_const(mDraining)) {
+        decryption.job->cancel();
+    }
+}
+
+std::shared_ptr<const DecryptedEntry>
+DecryptionService::decrypt(const QString &path,
+                           QObject *context,
+                           LineHandler lineHandler,
+                           ErrorHandler errorHandler,
+                           FinishedHandler finishedHandler,
+                           RequestKind kind)
+{
+    mEntries.removeIf([](const auto &it) {
+        return it.value().expired();
+    });
+
+    if (!mDecryptions.contains(path)) {
+        if (auto entry = mEntries.value(path).lock()) {
+            QTimer::singleShot(0, context, [entry, lineHandler = std::move(lineHandler), finishedHandler = std::move(finishedHandler)]() {
+                for (qsizetype i = 0; i < entry->lineCount(); ++i) {
+                    if (lineHandler(entry->line(i))) {
+                        break;
+                    }
+                }
+                if (finishedHandler) {
+                    finishedHandler();
+                }
+            });
+            return entry;
+        }
+
+        auto &decryption = mDecryptions[path];
+        decryption.id = ++mNextId;
+        decryption.entry = std::make_shared<DecryptedEntry>();
+        decryption.job = std::make_shared<Job>(this, path, decryption.id);
+        mQueue.push_back(path);
+    }
+
+    auto &decryption = mDecryptions[path];
+    decryption.requests.push_back({++mNextRequestId, context, std::move(lineHandler), std::move(errorHandler), std::move(finishedHandler), kind});
+    // The request gets the lines decrypted so far from the event loop, like all the others
+    QTimer::singleShot(0, this, [this, path, id = decryption.id]() {
+        addLines(path, id, {});
+    });
+    const auto entry = decryption.entry;
+    startWaiting();
+    return entry;
+}
+
+void DecryptionService::cancel(QObject *context)
+{
+    QStringList unused;
+    for (auto it = mDecryptions.begin(); it != mDecryptions.end(); ++it) {
+        it->requests.removeIf([context](const Request &request) {
+            return request.context.isNull() || request.context == context;
+        });
+        if (it->requests.isEmpty()) {
+            unused.push_back(it.key());
+        }
+    }
+    for (const auto &path : std::as_const(unused)) {
+        stop(path);
+    }
+
+    // Nobody is left to tell when the integrity check fails
+    mDraining.removeIf([context](QHash<quint64, Decryption>::iterator it) {
+        it.value().requests.removeIf([context](const Request &request) {
+            return request.context.isNull() || request.context == context;
+        });
+        if (it.value().requests.isEmpty()) {
+            it.value().job->cancel();
+            return true;
+        }
+        return false;
+    });
+}
+
+void DecryptionService::cancelWaiting()
+{
+    const auto queue = std::exchange(mQueue, QStringList());
+    for (const auto &path : queue) {
+        auto &decryption = mDecryptions[path];
+        QList<Request> canceled;
+        decryption.requests.removeIf([&canceled](const Request &request) {
+            if (request.kind == RequestKind::Batch) {
+                return false;
+            }
+            canceled.push_back(request);
+            return true;
+        });
+        // Batch requests keep their place in the queue
+        if (decryption.requests.isEmpty()) {
+            mDecryptions.remove(path);
+        } else {
+            mQueue.push_back(path);
+        }
+
+        for (const auto &request : std::as_const(canceled)) {
+            if (request.context.isNull()) {
+                continue;
+            }
+            QTimer::singleShot(0, request.context, [errorHandler = request.errorHandler]() {
+                errorHandler(canceledError());
+            });
+        }
+    }
+}
+
+QString DecryptionService::canceledError()
+{
+    return i18n("Decryption canceled");
+}
+
+void DecryptionService::warmUp()
+{
+    if (mRunning > 0 || (mLastWarmUp.isValid() && mLastWarmUp.durationElapsed() < warmUpInterval)) {
+        return;
+    }
+    mLastWarmUp.start();
+
+    const auto keyIds = PasswordsModel::passwordStoreKeyIds();
+    // One task per worker, so that all of them have their context ready
+    for (int i = 0; i < maxConcurrentDecryptions; ++i) {
+        mPool.start([keyIds, listKeys = i == 0]() {
+            const auto context = workerContext();
+            if (context == nullptr || !listKeys) {
+                return;
+            }
+
+            std::vector<QByteArray> patterns;
+            std::vector<const char *> patternPointers;
+            for (const auto &keyId : keyIds) {
+                patterns.push_back(keyId.toUtf8());
+            }
+            for (const auto &pattern : patterns) {
+                patternPointers.push_back(pattern.constData());
+            }
+            patternPointers.push_back(nullptr);
+
+            if (const auto error = context->startKeyListing(patternPointers.data(), /*secretOnly=*/true)) {
+                qCWarning(PLASMAPASS_LOG, "Failed to list secret keys: %s", error.asString());
+                return;
+            }
+            GpgME::Error error;
+            while (!error) {
+                context->nextKey(error);
+            }
+            context->endKeyListing();
+        });
+    }
+}
+
+void DecryptionService::startWaiting()
+{
+    while (mRunning < maxConcurrentDecryptions && !mQueue.isEmpty()) {
+        const auto path = mQueue.takeFirst();
+        run(path, mDecryptions[path]);
+    }
+}
+
+void DecryptionService::run(const QString &path, Decryption &decryption)
+{
+    decryption.started = true;
+    ++mRunning;
+    mPool.start([this, path, id = decryption.id, job = decryption.job]() {
+        const auto context = workerContext();
+
+        // The cipher text is read and the plain text written by this thread as the
+        // decryption goes, neither is ever held in memory as a whole
+        QString error;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(PLASMAPASS_LOG, "Failed to open password file: %s", qUtf8Printable(file.errorString()));
+            error = i18n("Failed to open password file: %1", file.errorString());
+        } else if (context == nullptr) {
+            qCWarning(PLASMAPASS_LOG, "Failed to create OpenPGP context");
+            error = i18n("Failed to decrypt password: %1", i18n("OpenPGP is not available"));
+        } else if (job->begin(context, file.size())) {
+            GpgME::Data cipherText(file.handle());
+            GpgME::Data plainText(job.get());
+            const auto result = context->decrypt(cipherText, plainText);
+            job->end();
+            if (result.error().isCanceled()) {
+                error = canceledError();
+            } else if (result.error()) {
+                const auto gpgError = QString::fromUtf8(result.error().asString());
+                qCWarning(PLASMAPASS_LOG, "Failed to decrypt password: %s", qUtf8Printable(gpgError));
+                error = i18n("Failed to decrypt password: %1", gpgError);
+            }
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [this, path, id, error]() {
+                finish(path, id, error);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void DecryptionService::stop(const QString &path)
+{
+    auto it = mDecryptions.find(path);
+    if (it == mDecryptions.end()) {
+        return;
+    }
+
+    if (it->started) {
+        it->job->cancel();
+    } else {
+        mQueue.removeOne(path);
+    }
+    mDecryptions.erase(it);
+}
+
+void DecryptionService::addLines(const QString &path, quint64 id, const std::shared_ptr<SecretBuffer> &lines)
+{
+    auto it = mDecryptions.find(path);
+    if (it == mDecryptions.end() || it->id != id) {
+        return; // canceled already
+    }
+
+    auto &entry = *it->entry;
+    if (lines != nullptr) {
+        const auto text = lines->view();
+        const auto offset = entry.text.size();
+        entry.text.append(text);
+        qsizetype start = 0;
+        for (auto end = text.indexOf(QLatin1Char('\n')); end != -1; end = text.indexOf(QLatin1Char('\n'), start)) {
+            entry.lines.emplace_back(offset + start, end - start);
+            start = end + 1;
+        }
+        it->job->recycle(lines);
+    }
+    if (!handleLines(path, id)) {
+        return;
+    }
+    it = mDecryptions.find(path);
+    if (it->started && !it->job->readToEnd()) {
+        // Nobody needs the rest of the plain text, don't keep it
+        drain(path);
+    }
+}
+
+void DecryptionService::drain(const QString &path)
+{
+    auto decryption = mDecryptions.take(path);
+    decryption.requests.removeIf([](const Request &request) {
+        return request.context.isNull();
+    });
+    if (decryption.requests.isEmpty()) {
+        decryption.job->cancel();
+        return;
+    }
+
+    // Later requests for the file start a new decryption, this one has no lines to give them
+    decryption.job->discardOutput();
+    mDraining.insert(decryption.id, std::move(decryption));
+}
+
+void DecryptionService::finish(const QString &path, quint64 id, const QString &error)
+{
+    // The worker is free for the next decryption, even when this one has been canceled
+    --mRunning;
+    startWaiting();
+
+    if (const auto draining = mDraining.find(id); draining != mDraining.end()) {
+        // The requests have all their lines, they only wait for the integrity check
+        const auto decryption = std::move(*draining);
+        mDraining.erase(draining);
+        for (const auto &request : decryption.requests) {
+            if (request.context.isNull()) {
+                continue;
+            }
+            if (!error.isNull()) {
+                request.errorHandler(error);
+            } else if (request.finishedHandler) {
+                request.finishedHandler();
+            }
+        }
+        return;
+    }
+
+    auto it = mDecryptions.find(path);
+    if (it == mDecryptions.end() || it->id != id) {
+        return; // canceled on purpose
+    }
+    auto message = error;
+    if (message.isNull() && it->job->isEmpty()) {
+        qCWarning(PLASMAPASS_LOG, "Password file is empty!");
+        message = i18n("No password found");
+    }
+    if (!message.isNull()) {
+        // The handlers may decrypt or cancel other files, they work on a copy of the requests
+        const auto decryption = mDecryptions.take(path);
+        for (const auto &request : decryption.requests) {
+            if (!request.context.isNull()) {
+                request.errorHandler(message);
+            }
+        }
+        return;
+    }
+
+    // Text after the last newline, possibly empty, is the last line
+    auto &entry = *it->entry;
+    const auto remainder = it->job->remainder();
+    entry.lines.emplace_back(entry.text.size(), remainder.size());
+    entry.text.append(remainder);
+    entry.complete = true;
+    handleLines(path, id);
+
+    it = mDecryptions.find(path);
+    if (it == mDecryptions.end() || it->id != id) {
+        return; // the line handlers canceled all of the requests
+    }
+    const auto decryption = std::move(*it);
+    mDecryptions.erase(it);
+    mEntries.insert(path, decryption.entry);
+    for (const auto &request : decryption.requests) {
+        if (!request.context.isNull() && request.finishedHandler) {
+            request.finishedHandler();
+        }
+    }
+}
+
+bool DecryptionService::handleLines(const QString &path, quint64 id)
+{
+    while (true) {
+        auto it = mDecryptions.find(path);
+        if (it == mDecryptions.end() || it->id != id) {
+            return false;
+        }
+
+        const auto entry = it->entry;
+        auto request = std::find_if(it->requests.begin(), it->requests.end(), [&entry](const Request &candidate) {
+            return !candidate.done && (candidate.context.isNull() || candidate.handledLines < entry->lineCount());
+        });
+        if (request == it->requests.end()) {
+            return std::all_of(it->requests.cbegin(), it->requests.cend(), [](const Request &candidate) {
+                return candidate.done;
+            });
+        }
+        if (request->context.isNull()) {
+            request->done = true;
+            continue;
+        }
+
+        // Neither the decryption nor the request may exist anymore once the handler returns
+        const auto requestId = request->id;
+        const auto lineHandler = request->lineHandler;
+        const auto line = request->handledLines++;
+        const bool done = lineHandler(entry->line(line));
+
+        it = mDecryptions.find(path);
+        if (it == mDecryptions.end() || it->id != id) {
+            return false;
+        }
+        request = std::find_if(it->requests.begin(), it->requests.end(), [requestId](const Request &candidate) {
+            return candidate.id == requestId;
+        });
+        if (request != it->requests.end()) {
+            request->done = done;
+        }
+    }
+}
+
+#include "moc_decryptionservice.cpp"
@@ -0,0 +1,206 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef DECRYPTIONSERVICE_H_
+#define DECRYPTIONSERVICE_H_
+
+#include "secretbuffer.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Plain text of a decrypted password file, split into lines.
+ */
+struct DecryptedEntry {
+    qsizetype lineCount() const
+    {
+        return static_cast<qsizetype>(lines.size());
+    }
+    QStringView line(qsizetype index) const
+    {
+        return text.view().sliced(lines[index].first, lines[index].second);
+    }
+
+    // The lines decrypted so far, separated by newlines
+    SecretBuffer text;
+    // Start and length of each line in the text
+    std::vector<std::pair<qsizetype, qsizetype>> lines;
+    // Whether the lines are the whole plain text. The plain text of large files is not
+    // kept once nobody needs more of their lines.
+    bool complete = false;
+};
+
+/**
+ * @brief Decrypts password files on behalf of the providers.
+ *
+ * The decryptions run on a small fixed pool of worker threads, each of which keeps its
+ * GPGME context for as long as it lives. Files waiting for a free worker are decrypted
+ * in the order in which they were first requested. Clicking through many entries
+ * quickly therefore queues them instead of starting a decryption for each at once.
+ *
+ * The plain text is read from the decryption as it is produced and handed out line
+ * by line, so a provider that needs only the first line gets it without waiting for
+ * the rest of the file. Once all requests for a large file have all the lines they
+ * need, the rest of it is still decrypted, but its plain text is thrown away as it comes.
+ * Only the end of the decryption tells whether the file is authentic (the MDC or AEAD
+ * check), and the requests must get the error when it is not, to take back a secret
+ * they handed out already.
+ *
+ * Each entry is decrypted only once, no matter how many providers need it. Requests
+ * for a file that is already being decrypted join the running decryption instead of
+ * starting another one (and another pinentry prompt). Completely decrypted entries
+ * are shared with later requests for as long as any of the providers holds on to them,
+ * that is while it has a secret in the clipboard.
+ */
+class DecryptionService : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Called with each line of the plain text, returns true when it needs no more lines.
+     * The line is valid only during the call, it points into the locked memory of the entry.
+     */
+    using LineHandler = std::function<bool(QStringView line)>;
+    /**
+     * Called with a user-visible error message when the decryption fails or is canceled.
+     */
+    using ErrorHandler = std::function<void(const QString &error)>;
+    /**
+     * Called once the whole file has been decrypted successfully, after the last line.
+     */
+    using FinishedHandler = std::function<void()>;
+
+    /**
+     * What a request is made for, see cancelWaiting().
+     */
+    enum class RequestKind {
+        Interactive, // an entry the user has picked in the popup
+        Batch, // one of many entries decrypted in the background, e.g. by the audit
+    };
+
+    static DecryptionService *instance();
+
+    ~DecryptionService() override;
+
+    /**
+     * @brief Decrypts the password file at @p path and passes its lines to @p lineHandler.
+     *
+     * The handlers are always called asynchronously and never after @p context is destroyed.
+     * The error handler may be called even after some lines have been handled, when the
+     * decryption fails at the end, e.g. because the integrity check of the file failed.
+     * Requests that need to know whether they have seen all of the lines pass a
+     * @p finishedHandler.
+     *
+     * @return the entry the lines come from, hold on to it to share it with later requests
+     */
+    std::shared_ptr<const DecryptedEntry> decrypt(const QString &path,
+                                                  QObject *context,
+                                                  LineHandler lineHandler,
+                                                  ErrorHandler errorHandler,
+                                                  FinishedHandler finishedHandler = {},
+                                                  RequestKind kind = RequestKind::Interactive);
+
+    /**
+     * @brief Drops all requests made for @p context, without calling their handlers.
+     *
+     * Decryptions nobody waits for anymore are removed from the queue or stopped.
+     */
+    void cancel(QObject *context);
+
+    /**
+     * @brief Cancels the decryptions that are still waiting for a free worker.
+     *
+     * Their interactive requests get an error, batch requests keep waiting as they do not
+     * belong to the popup. Running decryptions are left alone, they may be waiting for
+     * the user to enter the passphrase. Used when the popup is closed.
+     */
+    Q_INVOKABLE void cancelWaiting();
+
+    /**
+     * @brief The error message requests get when their decryption is canceled.
+     *
+     * Either by cancelWaiting() or by the user at the passphrase prompt.
+     */
+    static QString canceledError();
+
+    /**
+     * @brief Gets everything but the decryption itself ready in the background.
+     *
+     * Creates the GPGME contexts of the workers and lists the secret keys of the store,
+     * which starts gpg-agent when it is not running yet and has it load the keys, so
+     * that the first decryption after login is as fast as the later ones. Used when
+     * the popup is opened. Does nothing while decrypting or when done recently.
+     */
+    Q_INVOKABLE void warmUp();
+
+private:
+    explicit DecryptionService(QObject *parent = nullptr);
+
+    struct Request {
+        quint64 id = 0;
+        QPointer<QObject> context;
+        LineHandler lineHandler;
+        ErrorHandler errorHandler;
+        FinishedHandler finishedHandler;
+        RequestKind kind = RequestKind::Interactive;
+        qsizetype handledLines = 0;
+        bool done = false;
+    };
+
+    // State of a decryption shared with its worker thread
+    class Job;
+    struct Decryption {
+        quint64 id = 0;
+        std::shared_ptr<DecryptedEntry> entry;
+        std::shared_ptr<Job> job;
+        QList<Request> requests;
+        bool started = false;
+    };
+
+    void startWaiting();
+    void run(const QString &path, Decryption &decryption);
+    void stop(const QString &path);
+    // Lets the decryption finish without keeping its plain text, see the class description
+    void drain(const QString &path);
+    // Adds the text of complete lines, each of them ending with a newline, and hands the buffer back to the job
+    void addLines(const QString &path, quint64 id, const std::shared_ptr<SecretBuffer> &lines);
+    void finish(const QString &path, quint64 id, const QString &error);
+    /**
+     * Hands the new lines to the requests, returns true when they need no more. The
+     * handlers may decrypt or cancel other files, so the decryption is looked up again
+     * after each of them. Returns false when it has been stopped meanwhile.
+     */
+    bool handleLines(const QString &path, quint64 id);
+
+    QThreadPool mPool;
+    int mRunning = 0;
+    // Decryptions by path, both the running and the waiting ones
+    QHash<QString, Decryption> mDecryptions;
+    // Decryptions whose requests have all the lines they need, by id, see drain()
+    QHash<quint64, Decryption> mDraining;
+    // Paths of the decryptions waiting for a free worker, in the order of their requests
+    QStringList mQueue;
+    // Complete entries still held by some of the providers, by path
+    QHash<QString, std::weak_ptr<const DecryptedEntry>> mEntries;
+    quint64 mNextId = 0;
+    quint64 mNextRequestId = 0;
+    QElapsedTimer mLastWarmUp;
+};
+
+}
+
+#endif // DECRYPTIONSERVICE_H_
@@ -0,0 +1,432 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "metadataindex.h"
+#include "decryptionservice.h"
+#include "passwordsmodel.h"
+#include "plasmapass_debug.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <QGpgME/EncryptJob>
+#include <QGpgME/KeyListJob>
+#include <QGpgME/Protocol>
+#include <gpgme++/encryptionresult.h>
+#include <gpgme++/key.h>
+#include <gpgme++/keylistresult.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+using namespace PlasmaPass;
+using namespace std::chrono_literals;
+
+namespace
+{
+// First line of the index file, followed by a line per entry with its modification
+// time, name and fields, separated by tabs. It is decrypted line by line like the
+// password files, so it is a text file.
+const QString indexFileHeader = QStringLiteral("PPIN 2");
+constexpr const auto saveDelay = 10s;
+
+const QString passwordFileSuffix = QStringLiteral(".gpg");
+
+// Fields that are indexed. They are not expected to contain secrets.
+const QStringList indexedFields = {
+    QStringLiteral("login"),
+    QStringLiteral("user"),
+    QStringLiteral("username"),
+    QStringLiteral("email"),
+    QStringLiteral("url"),
+    QStringLiteral("website"),
+};
+
+// Returns the case-folded value of the line when it is one of the indexed fields, a null string otherwise
+QString indexedValue(QStringView line)
+{
+    line = line.trimmed();
+    const auto colon = line.indexOf(QLatin1Char(':'));
+    if (colon <= 0) {
+        return {};
+    }
+    const auto name = line.first(colon).trimmed();
+    const bool indexed = std::any_of(indexedFields.cbegin(), indexedFields.cend(), [name](const QString &field) {
+        return name.compare(field, Qt::CaseInsensitive) == 0;
+    });
+    if (!indexed) {
+        return {};
+    }
+    const auto value = line.sliced(colon + 1).trimmed();
+    return value.isEmpty() ? QString() : value.toString().toCaseFolded();
+}
+
+// Names and fields may contain anything but the tabs and newlines of the index file
+QString escaped(QStringView text)
+{
+    QString result;
+    result.reserve(text.size());
+    for (const auto c : text) {
+        if (c == QLatin1Char('\\')) {
+            result += QLatin1String("\\\\");
+        } else if (c == QLatin1Char('\t')) {
+            result += QLatin1String("\\t");
+        } else if (c == QLatin1Char('\n')) {
+            result += QLatin1String("\\n");
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+QString unescaped(QStringView text)
+{
+    QString result;
+    result.reserve(text.size());
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (text[i] != QLatin1Char('\\') || i + 1 == text.size()) {
+            result += text[i];
+            continue;
+        }
+        const auto c = text[++i];
+        if (c == QLatin1Char('t')) {
+            result += QLatin1Char('\t');
+        } else if (c == QLatin1Char('n')) {
+            result += QLatin1Char('\n');
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+MetadataIndex *MetadataIndex::instance()
+{
+    static QPointer<MetadataIndex> sInstance;
+    if (sInstance.isNull()) {
+        sInstance = new MetadataIndex(QCoreApplication::instance());
+    }
+    return sInstance;
+}
+
+MetadataIndex::MetadataIndex(QObject *parent)
+    : QObject(parent)
+    , mStore(PasswordsModel::passwordStore())
+    , mFilePath(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/plasma-pass/metadata-index.gpg"))
+{
+    mSaveTimer.setSingleShot(true);
+    mSaveTimer.setInterval(saveDelay);
+    connect(&mSaveTimer, &QTimer::timeout, this, &MetadataIndex::save);
+}
+
+MetadataIndex::~MetadataIndex() = default;
+
+bool MetadataIndex::isEnabled() const
+{
+    return mState != State::Disabled;
+}
+
+void MetadataIndex::setEnabled(bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return;
+    }
+
+    if (enabled) {
+        unlock();
+    } else {
+        mState = State::Disabled;
+        DecryptionService::instance()->cancel(this);
+        mDecrypting = false;
+        mSaveTimer.stop();
+        mEntries.clear();
+        mQueue.clear();
+        mQueuedModified.clear();
+        mDirty = false;
+        Q_EMIT indexChanged();
+    }
+}
+
+QString MetadataIndex::fields(const QString &fullName) const
+{
+    return mEntries.value(fullName).fields;
+}
+
+void MetadataIndex::unlock()
+{
+    mState = State::Unlocking;
+
+    if (!QFileInfo::exists(mFilePath)) {
+        mState = State::Ready;
+        update();
+        return;
+    }
+
+    // The worker that decrypts the index reads the file, only its lines come to the GUI thread
+    struct Contents {
+        QHash<QString, Entry> entries;
+        qsizetype lines = 0;
+        bool valid = true;
+    };
+    auto contents = std::make_shared<Contents>();
+    DecryptionService::instance()->decrypt(
+        mFilePath,
+        this,
+        [contents](QStringView line) {
+            if (contents->lines++ == 0) {
+                contents->valid = line == indexFileHeader;
+            } else {
+                contents->valid = parseEntry(line, contents->entries);
+            }
+            return !contents->valid;
+        },
+        [this](const QString &error) {
+            if (mState != State::Unlocking) {
+                return;
+            }
+
+            if (error == DecryptionService::canceledError()) {
+                // The user does not want to unlock the index now, don't bother them again.
+                qCDebug(PLASMAPASS_LOG, "Unlocking of the metadata index canceled");
+                mState = State::Disabled;
+                return;
+            }
+            qCWarning(PLASMAPASS_LOG, "Failed to decrypt metadata index, it will be rebuilt: %s", qUtf8Printable(error));
+            mState = State::Ready;
+            Q_EMIT indexChanged();
+            update();
+        },
+        [this, contents]() {
+            if (mState != State::Unlocking) {
+                return;
+            }
+
+            if (contents->valid) {
+                mEntries = std::move(contents->entries);
+            } else {
+                qCWarning(PLASMAPASS_LOG, "Metadata index is corrupted, it will be rebuilt");
+            }
+            mState = State::Ready;
+            Q_EMIT indexChanged();
+            update();
+        },
+        DecryptionService::RequestKind::Batch);
+}
+
+void MetadataIndex::update()
+{
+    if (mState != State::Ready) {
+        return;
+    }
+
+    QHash<QString, qint64> present;
+    QDirIterator it(mStore.absolutePath(), {QLatin1Char('*') + passwordFileSuffix}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const auto info = it.fileInfo();
+        auto fullName = mStore.relativeFilePath(info.absoluteFilePath());
+        fullName.chop(passwordFileSuffix.size());
+        present.insert(fullName, info.lastModified().toMSecsSinceEpoch());
+    }
+
+    const auto removed = mEntries.removeIf([&present](QHash<QString, Entry>::iterator entry) {
+        return !present.contains(entry.key());
+    });
+    if (removed > 0) {
+        mDirty = true;
+        Q_EMIT indexChanged();
+    }
+
+    for (auto file = present.cbegin(), end = present.cend(); file != end; ++file) {
+        const auto entry = mEntries.constFind(file.key());
+        if (entry != mEntries.cend() && entry->modified == file.value()) {
+            continue;
+        }
+        if (!mQueuedModified.contains(file.key())) {
+            mQueue.push_back(file.key());
+        }
+        mQueuedModified.insert(file.key(), file.value());
+    }
+
+    if (!mQueue.isEmpty()) {
+        processQueue();
+    } else if (mDirty) {
+        mSaveTimer.start();
+    }
+}
+
+void MetadataIndex::processQueue()
+{
+    if (mDecrypting || mState != State::Ready || mQueue.isEmpty()) {
+        return;
+    }
+
+    // Decrypt one entry at a time, this runs in the background and should not compete
+    // with the user copying passwords.
+    const auto fullName = mQueue.takeFirst();
+    mDecrypting = true;
+
+    // Only the values of the indexed fields are copied out of the plain text
+    struct Fields {
+        QStringList values;
+        qsizetype lines = 0;
+    };
+    auto fields = std::make_shared<Fields>();
+    DecryptionService::instance()->decrypt(
+        mStore.absoluteFilePath(fullName + passwordFileSuffix),
+        this,
+        [fields](QStringView line) {
+            // The first line is the password itself
+            if (fields->lines++ > 0) {
+                if (auto value = indexedValue(line); !value.isNull()) {
+                    fields->values.push_back(std::move(value));
+                }
+            }
+            return false;
+        },
+        [this, fullName](const QString &error) {
+            mDecrypting = false;
+            const auto modified = mQueuedModified.take(fullName);
+            if (mState != State::Ready) {
+                return;
+            }
+
+            if (error == DecryptionService::canceledError()) {
+                // Don't ask the user for a passphrase for every other entry again
+                qCDebug(PLASMAPASS_LOG, "Metadata indexing canceled");
+                mQueue.clear();
+                mQueuedModified.clear();
+            } else {
+                qCWarning(PLASMAPASS_LOG, "Failed to decrypt %s for metadata index: %s", qUtf8Printable(fullName), qUtf8Printable(error));
+                // Remember the failure, so that we don't retry until the file changes
+                mEntries.insert(fullName, Entry{modified, {}});
+                mDirty = true;
+            }
+            entryProcessed();
+        },
+        [this, fullName, fields]() {
+            mDecrypting = false;
+            const auto modified = mQueuedModified.take(fullName);
+            if (mState != State::Ready) {
+                return;
+            }
+
+            mEntries.insert(fullName, Entry{modified, fields->values.join(QLatin1Char('\n'))});
+            mDirty = true;
+            entryProcessed();
+        },
+        DecryptionService::RequestKind::Batch);
+}
+
+void MetadataIndex::entryProcessed()
+{
+    if (mQueue.isEmpty()) {
+        Q_EMIT indexChanged();
+        if (mDirty) {
+            mSaveTimer.start();
+        }
+    } else {
+        processQueue();
+    }
+}
+
+void MetadataIndex::save()
+{
+    if (mState != State::Ready || !mDirty || mSaving) {
+        return;
+    }
+
+    const auto keyIds = PasswordsModel::passwordStoreKeyIds();
+    if (keyIds.isEmpty()) {
+        qCWarning(PLASMAPASS_LOG, "No keys found in .gpg-id, cannot save metadata index");
+        return;
+    }
+
+    auto keyListJob = QGpgME::openpgp()->keyListJob(/*remote=*/false);
+    connect(keyListJob, &QGpgME::KeyListJob::result, this, [this](const GpgME::KeyListResult &result, const std::vector<GpgME::Key> &keys) {
+        if (result.error() || keys.empty()) {
+            qCWarning(PLASMAPASS_LOG, "Failed to find keys to encrypt metadata index to: %s", result.error().asString());
+            mSaving = false;
+            return;
+        }
+        encryptAndSave(keys);
+    });
+
+    const auto error = keyListJob->start(keyIds, /*secretOnly=*/false);
+    if (error) {
+        qCWarning(PLASMAPASS_LOG, "Failed to find keys to encrypt metadata index to: %s", error.asString());
+        return;
+    }
+    mSaving = true;
+}
+
+void MetadataIndex::encryptAndSave(const std::vector<GpgME::Key> &keys)
+{
+    auto encryptJob = QGpgME::openpgp()->encryptJob(/*armor=*/false, /*textmode=*/false);
+    connect(encryptJob, &QGpgME::EncryptJob::result, this, [this](const GpgME::EncryptionResult &result, const QByteArray &cipherText) {
+        mSaving = false;
+        if (result.error()) {
+            qCWarning(PLASMAPASS_LOG, "Failed to encrypt metadata index: %s", result.error().asString());
+            mDirty = true;
+            return;
+        }
+
+        if (!QDir().mkpath(QFileInfo(mFilePath).absolutePath())) {
+            qCWarning(PLASMAPASS_LOG, "Failed to create directory for metadata index %s", qUtf8Printable(mFilePath));
+            mDirty = true;
+            return;
+        }
+
+        QSaveFile file(mFilePath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(cipherText) != cipherText.size() || !file.commit()) {
+            qCWarning(PLASMAPASS_LOG, "Failed to write metadata index: %s", qUtf8Printable(file.errorString()));
+            mDirty = true;
+        }
+    });
+
+    // Changes done while the job is running will be saved next time
+    mDirty = false;
+    const auto error = encryptJob->start(keys, serialize(), /*alwaysTrust=*/true);
+    if (error) {
+        qCWarning(PLASMAPASS_LOG, "Failed to encrypt metadata index: %s", error.asString());
+        mSaving = false;
+        mDirty = true;
+    }
+}
+
+QByteArray MetadataIndex::serialize() const
+{
+    QString data = indexFileHeader;
+    for (auto it = mEntries.cbegin(), end = mEntries.cend(); it != end; ++it) {
+        data += QLatin1Char('\n') + QString::number(it->modified) + QLatin1Char('\t') + escaped(it.key()) + QLatin1Char('\t') + escaped(it->fields);
+    }
+    return data.toUtf8();
+}
+
+bool MetadataIndex::parseEntry(QStringView line, QHash<QString, Entry> &entries)
+{
+    const auto parts = line.split(QLatin1Char('\t'));
+    if (parts.size() != 3) {
+        return false;
+    }
+
+    bool ok = false;
+    const auto modified = parts[0].toLongLong(&ok);
+    if (!ok) {
+        return false;
+    }
+    entries.insert(unescaped(parts[1]), Entry{modified, unescaped(parts[2])});
+    return true;
+}
+
+#include "moc_metadataindex.cpp"
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef METADATAINDEX_H_
+#define METADATAINDEX_H_
+
+#include <QDir>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+#include <vector>
+
+namespace GpgME
+{
+class Key;
+}
+
+namespace PlasmaPass
+{
+/**
+ * @brief Searchable index of non-secret fields of the password entries.
+ *
+ * Passwords in the store often carry lines like "login: foo" or "url: https://..."
+ * after the password itself. To be able to search those without decrypting every
+ * entry on each query, the index decrypts each entry once in the background and keeps
+ * the values of selected fields. The index itself is stored encrypted to the keys of
+ * the password store (as listed in its .gpg-id file), so it is unlocked with a single
+ * decryption per session and only entries whose files have changed since then are
+ * decrypted again.
+ *
+ * The index is opt-in, it does nothing until enabled.
+ */
+class MetadataIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static MetadataIndex *instance();
+
+    ~MetadataIndex() override;
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief Returns case-folded values of the indexed fields of given entry, separated by newlines.
+     */
+    QString fields(const QString &fullName) const;
+
+    /**
+     * @brief Rescans the password store and indexes new or modified entries in the background.
+     */
+    void update();
+
+Q_SIGNALS:
+    void indexChanged();
+
+private:
+    explicit MetadataIndex(QObject *parent = nullptr);
+
+    struct Entry {
+        qint64 modified = 0; // msecs since epoch
+        QString fields;
+    };
+
+    enum class State {
+        Disabled,
+        Unlocking,
+        Ready,
+    };
+
+    void unlock();
+    void processQueue();
+    void entryProcessed();
+    void save();
+    void encryptAndSave(const std::vector<GpgME::Key> &keys);
+
+    QByteArray serialize() const;
+    // Adds the entry of a line of the index file to @p entries, returns false when the line is malformed
+    static bool parseEntry(QStringView line, QHash<QString, Entry> &entries);
+
+    QDir mStore;
+    QString mFilePath;
+    State mState = State::Disabled;
+    QHash<QString, Entry> mEntries;
+    QStringList mQueue;
+    QHash<QString, qint64> mQueuedModified;
+    bool mDecrypting = false;
+    bool mDirty = false;
+    bool mSaving = false;
+    QTimer mSaveTimer;
+};
+
+}
+
+#endif // METADATAINDEX_H_
@@ -0,0 +1,354 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "otpdashboard.h"
+#include "deadlinescheduler.h"
+#include "decryptionservice.h"
+#include "passwordsmodel.h"
+#include "plasmapass_debug.h"
+
+#include <QDBusConnection>
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+using namespace PlasmaPass;
+
+namespace
+{
+// Entries decrypted at the same time, as many as DecryptionService has workers. An entry
+// the user copies meanwhile is queued behind at most these.
+constexpr const int maxRunningDecryptions = 2;
+
+const QString passwordFileSuffix = QStringLiteral(".gpg");
+const QString otpAuthSchema = QStringLiteral("otpauth://");
+
+// Entries without an OTP secret and their modification times, by path. Not a member, the
+// dashboards come and go with their page and this is all that is worth keeping between them.
+QHash<QString, qint64> &entriesWithoutOtp()
+{
+    static QHash<QString, qint64> entries;
+    return entries;
+}
+
+} // namespace
+
+OTPDashboard::OTPDashboard(QObject *parent)
+    : QAbstractListModel(parent)
+    , mStore(PasswordsModel::passwordStore())
+{
+    QDBusConnection::sessionBus().connect(QStringLiteral("org.freedesktop.ScreenSaver"),
+                                          QStringLiteral("/ScreenSaver"),
+                                          QStringLiteral("org.freedesktop.ScreenSaver"),
+                                          QStringLiteral("ActiveChanged"),
+                                          this,
+                                          SLOT(onScreenSaverActiveChanged(bool)));
+}
+
+OTPDashboard::~OTPDashboard()
+{
+    DecryptionService::instance()->cancel(this);
+    DeadlineScheduler::instance()->cancel(mRefreshId);
+}
+
+QString OTPDashboard::folder() const
+{
+    return mFolder;
+}
+
+void OTPDashboard::setFolder(const QString &folder)
+{
+    if (mFolder != folder) {
+        mFolder = folder;
+        Q_EMIT folderChanged();
+    }
+}
+
+bool OTPDashboard::isLoading() const
+{
+    return mLoading;
+}
+
+int OTPDashboard::total() const
+{
+    return mTotal;
+}
+
+int OTPDashboard::done() const
+{
+    return mDone;
+}
+
+int OTPDashboard::failedCount() const
+{
+    return mFailed;
+}
+
+qint64 OTPDashboard::nextRefresh() const
+{
+    return mNextRefresh;
+}
+
+QHash<int, QByteArray> OTPDashboard::roleNames() const
+{
+    return {
+        {FullNameRole, "fullName"},
+        {CodeRole, "code"},
+        {PeriodRole, "period"},
+    };
+}
+
+int OTPDashboard::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(mEntries.size());
+}
+
+QVariant OTPDashboard::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return {};
+    }
+
+    const auto &entry = mEntries[index.row()];
+    switch (role) {
+    case FullNameRole:
+        return entry.fullName;
+    case CodeRole:
+        // Only for QML, which cannot do without a copy
+        return entry.code.toString();
+    case PeriodRole:
+        return entry.generator.period();
+    }
+    return {};
+}
+
+void OTPDashboard::start()
+{
+    if (mLoading) {
+        return;
+    }
+
+    stop();
+
+    const auto root = mFolder.isEmpty() ? mStore.absolutePath() : mStore.absoluteFilePath(mFolder);
+    QDirIterator it(root, {QLatin1Char('*') + passwordFileSuffix}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const auto info = it.fileInfo();
+        auto fullName = mStore.relativeFilePath(info.absoluteFilePath());
+        fullName.chop(passwordFileSuffix.size());
+        const auto modified = info.lastModified().toMSecsSinceEpoch();
+
+        // Don't decrypt again entries that had no OTP secret last time, unless they have changed
+        if (entriesWithoutOtp().value(info.absoluteFilePath(), -1) == modified) {
+            continue;
+        }
+        mPending.push_back({fullName, modified});
+    }
+
+    mTotal = static_cast<int>(mPending.size());
+    mDone = 0;
+    mFailed = 0;
+    Q_EMIT progressChanged();
+    if (mPending.isEmpty()) {
+        return;
+    }
+
+    setLoading(true);
+    startNext();
+}
+
+void OTPDashboard::stop()
+{
+    // Entries already decrypted may still report back, they belong to the stopped run
+    ++mRun;
+    mPending.clear();
+    DecryptionService::instance()->cancel(this);
+    mRunningDecryptions = 0;
+    setLoading(false);
+
+    DeadlineScheduler::instance()->cancel(std::exchange(mRefreshId, 0));
+    if (mNextRefresh != 0) {
+        mNextRefresh = 0;
+        Q_EMIT nextRefreshChanged();
+    }
+
+    // Wipes the keys and the codes
+    beginResetModel();
+    mEntries.clear();
+    endResetModel();
+}
+
+void OTPDashboard::startNext()
+{
+    while (mLoading && mRunningDecryptions < maxRunningDecryptions && !mPending.isEmpty()) {
+        const auto [fullName, modified] = mPending.takeFirst();
+        // Set once the entry is done with, the decryption may go on or fail after the OTP line
+        auto handled = std::make_shared<bool>(false);
+        ++mRunningDecryptions;
+        // The returned entry is not kept, the plain text is dropped as soon as the decryption finishes
+        DecryptionService::instance()->decrypt(
+            mStore.absoluteFilePath(fullName + passwordFileSuffix),
+            this,
+            [this, run = mRun, fullName, modified, handled](QStringView line) {
+                const auto trimmed = line.trimmed();
+                if (!trimmed.startsWith(otpAuthSchema)) {
+                    return false;
+                }
+                *handled = true;
+                auto generator = std::make_shared<TOTPGenerator>();
+                const auto error = generator->load(trimmed);
+                // Not from within the handler, finishEntry() starts the next decryptions
+                QTimer::singleShot(0, this, [this, run, fullName, modified, generator, error]() {
+                    if (run == mRun) {
+                        finishEntry(fullName, modified, std::move(*generator), error);
+                    }
+                });
+                return true;
+            },
+            [this, run = mRun, fullName, modified, handled](const QString &error) {
+                if (run != mRun) {
+                    return;
+                }
+                if (!std::exchange(*handled, true)) {
+                    finishEntry(fullName, modified, {}, error);
+                } else {
+                    // The decryption failed at its very end, after the OTP line. Queued
+                    // behind the finishEntry() of the line handler, which adds the entry.
+                    QTimer::singleShot(0, this, [this, run, fullName]() {
+                        if (run == mRun) {
+                            removeEntry(fullName);
+                        }
+                    });
+                }
+            },
+            [this, run = mRun, fullName, modified, handled]() {
+                if (!std::exchange(*handled, true) && run == mRun) {
+                    finishEntry(fullName, modified, {}, {});
+                }
+            },
+            DecryptionService::RequestKind::Batch);
+    }
+
+    if (mRunningDecryptions == 0 && mPending.isEmpty()) {
+        setLoading(false);
+    }
+}
+
+void OTPDashboard::finishEntry(const QString &fullName, qint64 modified, TOTPGenerator generator, const QString &error)
+{
+    --mRunningDecryptions;
+    ++mDone;
+
+    if (!error.isNull()) {
+        qCDebug(PLASMAPASS_LOG, "Failed to get OTP of %s: %s", qUtf8Printable(fullName), qUtf8Printable(error));
+        ++mFailed;
+    } else if (generator.isNull()) {
+        entriesWithoutOtp().insert(mStore.absoluteFilePath(fullName + passwordFileSuffix), modified);
+    } else {
+        entriesWithoutOtp().remove(mStore.absoluteFilePath(fullName + passwordFileSuffix));
+        const auto it = std::lower_bound(mEntries.cbegin(), mEntries.cend(), fullName, [](const Entry &entry, const QString &name) {
+            return entry.fullName < name;
+        });
+        const auto row = static_cast<int>(std::distance(mEntries.cbegin(), it));
+        beginInsertRows({}, row, row);
+        mEntries.insert(it, Entry{fullName, std::move(generator), {}, -1});
+        endInsertRows();
+        // Generates the code of the new entry, the others are up to date
+        refresh(QDateTime::currentSecsSinceEpoch());
+    }
+
+    Q_EMIT progressChanged();
+    startNext();
+}
+
+void OTPDashboard::removeEntry(const QString &fullName)
+{
+    const auto it = std::find_if(mEntries.cbegin(), mEntries.cend(), [&fullName](const Entry &entry) {
+        return entry.fullName == fullName;
+    });
+    if (it == mEntries.cend()) {
+        return;
+    }
+
+    const auto row = static_cast<int>(std::distance(mEntries.cbegin(), it));
+    beginRemoveRows({}, row, row);
+    mEntries.erase(it);
+    endRemoveRows();
+    ++mFailed;
+    Q_EMIT progressChanged();
+    scheduleRefresh(QDateTime::currentSecsSinceEpoch());
+}
+
+void OTPDashboard::refresh(qint64 now)
+{
+    int first = -1;
+    int last = -1;
+    for (int row = 0; row < static_cast<int>(mEntries.size()); ++row) {
+        auto &entry = mEntries[row];
+        const auto step = now / entry.generator.period();
+        if (step == entry.step) {
+            continue;
+        }
+        entry.code = entry.generator.code(now);
+        entry.step = step;
+        first = first == -1 ? row : first;
+        last = row;
+    }
+    if (first != -1) {
+        Q_EMIT dataChanged(index(first), index(last), {CodeRole});
+    }
+
+    scheduleRefresh(now);
+}
+
+void OTPDashboard::scheduleRefresh(qint64 now)
+{
+    DeadlineScheduler::instance()->cancel(std::exchange(mRefreshId, 0));
+
+    // Entries with the same period change their codes at the same time, one deadline serves all
+    qint64 nextStep = 0;
+    for (const auto &entry : mEntries) {
+        const auto step = entry.generator.nextStep(now);
+        nextStep = nextStep == 0 ? step : std::min(nextStep, step);
+    }
+
+    if (mNextRefresh != nextStep * 1000) {
+        mNextRefresh = nextStep * 1000;
+        Q_EMIT nextRefreshChanged();
+    }
+    if (nextStep == 0) {
+        return;
+    }
+
+    const QDeadlineTimer deadline(mNextRefresh - QDateTime::currentMSecsSinceEpoch(), Qt::PreciseTimer);
+    mRefreshId = DeadlineScheduler::instance()->schedule(deadline, this, [this, nextStep]() {
+        mRefreshId = 0;
+        // The timer may fire a little early, the codes are those of the new step nonetheless
+        refresh(std::max(QDateTime::currentSecsSinceEpoch(), nextStep));
+    });
+}
+
+void OTPDashboard::setLoading(bool loading)
+{
+    if (mLoading != loading) {
+        mLoading = loading;
+        Q_EMIT loadingChanged();
+    }
+}
+
+void OTPDashboard::onScreenSaverActiveChanged(bool active)
+{
+    if (active) {
+        stop();
+    }
+}
+
+#include "moc_otpdashboard.cpp"
@@ -0,0 +1,130 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef OTPDASHBOARD_H_
+#define OTPDASHBOARD_H_
+
+#include "secretbuffer.h"
+#include "totpgenerator.h"
+
+#include <QAbstractListModel>
+#include <QDir>
+#include <QHash>
+#include <QList>
+
+#include <vector>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Current TOTP codes of all entries with an OTP secret in the store, or in a folder.
+ *
+ * start() decrypts the entries in one batch through the DecryptionService, a few at a
+ * time, and keeps only the decoded keys of those with an otpauth://totp/ line. Entries
+ * found without one are remembered for as long as the process runs, by all dashboards,
+ * and not decrypted again by a start() unless they change.
+ *
+ * All codes are regenerated together by a single deadline at the start of the next time
+ * step, each entry costs one HMAC per step and has no timer of its own. The keys and
+ * codes are wiped by stop(), when the screen gets locked and when the model is destroyed.
+ */
+class OTPDashboard : public QAbstractListModel
+{
+    Q_OBJECT
+
+    /**
+     * Folder to look for OTP entries in, relative to the password store. The whole store when empty.
+     */
+    Q_PROPERTY(QString folder READ folder WRITE setFolder NOTIFY folderChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
+    /**
+     * Number of entries to decrypt in the current (or last) start() and how many of them are done.
+     */
+    Q_PROPERTY(int total READ total NOTIFY progressChanged)
+    Q_PROPERTY(int done READ done NOTIFY progressChanged)
+    Q_PROPERTY(int failedCount READ failedCount NOTIFY progressChanged)
+    /**
+     * When the codes are regenerated next, in milliseconds since the epoch, 0 when there are none.
+     * Views animate the shared countdown to it themselves.
+     */
+    Q_PROPERTY(qint64 nextRefresh READ nextRefresh NOTIFY nextRefreshChanged)
+
+public:
+    enum Roles {
+        FullNameRole = Qt::DisplayRole,
+        CodeRole = Qt::UserRole,
+        /**
+         * Length of the time step of the code in seconds.
+         */
+        PeriodRole,
+    };
+
+    explicit OTPDashboard(QObject *parent = nullptr);
+    ~OTPDashboard() override;
+
+    QString folder() const;
+    void setFolder(const QString &folder);
+
+    bool isLoading() const;
+    int total() const;
+    int done() const;
+    int failedCount() const;
+    qint64 nextRefresh() const;
+
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    /**
+     * @brief Decrypts the entries of folder() and lists those with an OTP secret.
+     */
+    Q_INVOKABLE void start();
+    /**
+     * @brief Stops decrypting, wipes all keys and codes and removes all rows.
+     */
+    Q_INVOKABLE void stop();
+
+Q_SIGNALS:
+    void folderChanged();
+    void loadingChanged();
+    void progressChanged();
+    void nextRefreshChanged();
+
+private Q_SLOTS:
+    void onScreenSaverActiveChanged(bool active);
+
+private:
+    struct Entry {
+        QString fullName;
+        TOTPGenerator generator;
+        SecretBuffer code;
+        qint64 step = -1; // of the code, in periods since the epoch
+    };
+
+    void startNext();
+    void finishEntry(const QString &fullName, qint64 modified, TOTPGenerator generator, const QString &error);
+    void removeEntry(const QString &fullName);
+    void refresh(qint64 now); // in seconds since the epoch
+    void scheduleRefresh(qint64 now);
+    void setLoading(bool loading);
+
+    QDir mStore;
+    QString mFolder;
+    std::vector<Entry> mEntries;
+    // Entries waiting to be decrypted and their modification times
+    QList<std::pair<QString, qint64>> mPending;
+    int mRunningDecryptions = 0;
+    // Tells results of the current start() from those of stopped ones
+    quint64 mRun = 0;
+    int mTotal = 0;
+    int mDone = 0;
+    int mFailed = 0;
+    bool mLoading = false;
+    qint64 mNextRefresh = 0;
+    quint64 mRefreshId = 0; // in DeadlineScheduler
+};
+
+}
+
+#endif // OTPDASHBOARD_H_
@@ -3,17 +3,16 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "otpprovider.h"
+#include "deadlinescheduler.h"
 
-#include <QUrl>
-#include <QUrlQuery>
-#include <QDebug>
 #include <QDateTime>
+#include <QDBusConnection>
 
 #include <KLocalizedString>
 
+#include <algorithm>
 #include <chrono>
-
-#include <liboath/oath.h>
+#include <utility>
 
 using namespace PlasmaPass;
 using namespace std::chrono_literals;
@@ -21,19 +20,37 @@ using namespace std::chrono_literals;
 namespace {
 
 static const QString otpAuthSchema = QStringLiteral("otpauth://");
-static const QString secretQueryItem = QStringLiteral("secret");
 
-QString parseOtpType(const QUrl &url)
-{
-    return url.host();
-}
+constexpr const auto DefaultOTPTimeout = 30s;
 
 } // namespace
 
-OTPProvider::OTPProvider(const QString &path, QObject *parent)
+OTPProvider::OTPProvider(const QString &path, std::chrono::seconds session, QObject *parent)
     : ProviderBase(path, parent)
+    , mSession(session)
+{
+    setSecretTimeout(mSession > 0s ? mSession : DefaultOTPTimeout);
+
+    // Whenever the code goes away (expired, reset or failed) the key goes with it
+    connect(this, &ProviderBase::validChanged, this, [this]() {
+        if (!isValid()) {
+            stopSession();
+        }
+    });
+
+    if (mSession > 0s) {
+        QDBusConnection::sessionBus().connect(QStringLiteral("org.freedesktop.ScreenSaver"),
+                                              QStringLiteral("/ScreenSaver"),
+                                              QStringLiteral("org.freedesktop.ScreenSaver"),
+                                              QStringLiteral("ActiveChanged"),
+                                              this,
+                                              SLOT(onScreenSaverActiveChanged(bool)));
+    }
+}
+
+OTPProvider::~OTPProvider()
 {
-    setSecretTimeout(30s);
+    DeadlineScheduler::instance()->cancel(mRefreshId);
 }
 
 ProviderBase::HandlingResult OTPProvider::handleSecret(QStringView secret)
@@ -42,37 +59,57 @@ ProviderBase::HandlingResult OTPProvider::handleSecret(QStringView secret)
         return HandlingResult::Continue;
     }
 
-    QUrl url(secret.toString());
-    const auto otpType = parseOtpType(url);
-    if (otpType == QLatin1String("totp")) {
-        handleTOTP(url);
-    } else {
-        setError(i18n("Unsupported OTP type %1", otpType));
+    const auto error = mGenerator.load(secret);
+    if (!error.isNull()) {
+        setError(error);
+        return HandlingResult::Stop;
+    }
+
+    auto code = mGenerator.code(QDateTime::currentSecsSinceEpoch());
+    if (code.isNull()) {
+        mGenerator.clear();
+        setError(i18n("Failed to generate the OTP code"));
         return HandlingResult::Stop;
     }
+    setSecret(std::move(code));
+
+    if (mSession > 0s) {
+        scheduleRefresh();
+    } else {
+        mGenerator.clear();
+    }
 
     return HandlingResult::Stop;
 }
 
+void OTPProvider::scheduleRefresh()
+{
+    const auto nextStep = mGenerator.nextStep(QDateTime::currentSecsSinceEpoch());
+    const QDeadlineTimer deadline(nextStep * 1000 - QDateTime::currentMSecsSinceEpoch(), Qt::PreciseTimer);
+    mRefreshId = DeadlineScheduler::instance()->schedule(deadline, this, [this, nextStep]() {
+        mRefreshId = 0;
+        // The timer may fire a little early, the code is that of the new step nonetheless
+        auto code = mGenerator.code(std::max(QDateTime::currentSecsSinceEpoch(), nextStep));
+        if (code.isNull()) {
+            expireSecret();
+            return;
+        }
+        replaceSecret(std::move(code));
+        scheduleRefresh();
+    });
+}
+
+void OTPProvider::stopSession()
+{
+    DeadlineScheduler::instance()->cancel(std::exchange(mRefreshId, 0));
+    mGenerator.clear();
+}
 
-void OTPProvider::handleTOTP(const QUrl &url)
+void OTPProvider::onScreenSaverActiveChanged(bool active)
 {
-    const QUrlQuery query(url.query());
-    const auto secret = query.queryItemValue(secretQueryItem).toUtf8();
-
-    char *decodedSecret = {};
-    size_t decodedSecretLen = 0;
-    oath_base32_decode(secret.data(), secret.size(), &decodedSecret, &decodedSecretLen);
-
-    char output_otp[6] = {};
-    oath_totp_generate(decodedSecret, decodedSecretLen,
-            QDateTime::currentDateTime().toSecsSinceEpoch(),
-            OATH_TOTP_DEFAULT_TIME_STEP_SIZE,
-            OATH_TOTP_DEFAULT_START_TIME,
-            6,
-            output_otp);
-
-    setSecret(QString::fromLatin1(output_otp, sizeof(output_otp)));
+    if (active && isValid()) {
+        expireSecret();
+    }
 }
 
 #include "moc_otpprovider.cpp"
@@ -6,6 +6,9 @@
 #define OTPPROVIDER_H_
 
 #include "providerbase.h"
+#include "totpgenerator.h"
+
+#include <chrono>
 
 namespace PlasmaPass
 {
@@ -17,12 +20,26 @@ class OTPProvider : public ProviderBase
 
     friend class PasswordsModel;
 protected:
-    explicit OTPProvider(const QString &path, QObject *parent = nullptr);
+    /**
+     * With a non-zero @p session the decoded key is kept for that long and a new code
+     * replaces the current one at every step, without decrypting the entry again.
+     * The key is wiped when the session ends or the screen gets locked.
+     */
+    explicit OTPProvider(const QString &path, std::chrono::seconds session = {}, QObject *parent = nullptr);
+    ~OTPProvider() override;
 
     HandlingResult handleSecret(QStringView secret) override;
 
+private Q_SLOTS:
+    void onScreenSaverActiveChanged(bool active);
+
 private:
-    void handleTOTP(const QUrl &url);
+    void scheduleRefresh();
+    void stopSession();
+
+    TOTPGenerator mGenerator;
+    std::chrono::seconds mSession;
+    quint64 mRefreshId = 0; // in DeadlineScheduler
 };
 
 }
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef PARALLELCHUNKS_H_
+#define PARALLELCHUNKS_H_
+
+#include <QList>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <utility>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Number of items processed by a single task of blockingMapChunks().
+ *
+ * Small enough to balance the load between the threads, large enough for the
+ * overhead of each task to be negligible and for a chunk of results to fill
+ * whole cache lines.
+ */
+constexpr const int DefaultChunkSize = 1024;
+
+/**
+ * @brief Calls @p function(first, last) for consecutive ranges covering [0, @p count).
+ *
+ * The ranges are processed in parallel on @p pool, the idle threads pick up the
+ * remaining ranges as they finish theirs. The call blocks until all ranges are done.
+ * When everything fits into a single range it is processed directly in the calling
+ * thread.
+ *
+ * The function is expected to write its results into its own part of an output that
+ * has been sized beforehand, so there is nothing to lock and nothing to merge.
+ */
+template<typename Function>
+void blockingMapChunks(int count, Function function, int chunkSize = DefaultChunkSize, QThreadPool *pool = QThreadPool::globalInstance())
+{
+    if (count <= chunkSize) {
+        if (count > 0) {
+            function(0, count);
+        }
+        return;
+    }
+
+    QList<std::pair<int, int>> chunks;
+    chunks.reserve((count + chunkSize - 1) / chunkSize);
+    for (int first = 0; first < count; first += chunkSize) {
+        chunks.push_back({first, std::min(first + chunkSize, count)});
+    }
+    QtConcurrent::blockingMap(pool, chunks, [&function](const std::pair<int, int> &chunk) {
+        function(chunk.first, chunk.second);
+    });
+}
+
+}
+
+#endif // PARALLELCHUNKS_H_
@@ -0,0 +1,379 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "passwordaudit.h"
+#include "decryptionservice.h"
+#include "passwordsmodel.h"
+#include "plasmapass_debug.h"
+
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QSet>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+using namespace PlasmaPass;
+
+namespace
+{
+// Entries decrypted at the same time, as many as DecryptionService has workers. An entry
+// the user copies during the audit is queued behind at most these.
+constexpr const int maxRunningDecryptions = 2;
+// Passwords with a lower strength are counted as weak
+constexpr const int weakStrength = 2;
+
+const QString passwordFileSuffix = QStringLiteral(".gpg");
+const QString otpAuthSchema = QStringLiteral("otpauth://");
+
+/**
+ * Estimates the strength of a password from 0 to 4 from its length and the classes of
+ * characters it uses. Repeated characters count less, so "aaaaaaaaaaaaaaaa" is weak.
+ * It knows nothing about dictionary words, so it is rather generous.
+ */
+int estimateStrength(QStringView password)
+{
+    bool lower = false;
+    bool upper = false;
+    bool digit = false;
+    bool symbol = false;
+    bool other = false;
+    QSet<QChar> distinct;
+    for (const auto c : password) {
+        if (c >= QLatin1Char('a') && c <= QLatin1Char('z')) {
+            lower = true;
+        } else if (c >= QLatin1Char('A') && c <= QLatin1Char('Z')) {
+            upper = true;
+        } else if (c >= QLatin1Char('0') && c <= QLatin1Char('9')) {
+            digit = true;
+        } else if (c.unicode() < 0x80) {
+            symbol = true;
+        } else {
+            other = true;
+        }
+        distinct.insert(c);
+    }
+
+    const int poolSize = (lower ? 26 : 0) + (upper ? 26 : 0) + (digit ? 10 : 0) + (symbol ? 33 : 0) + (other ? 100 : 0);
+    if (poolSize == 0) {
+        return 0;
+    }
+    const auto length = std::min(password.size(), 2 * distinct.size());
+    const auto bits = static_cast<double>(length) * std::log2(poolSize);
+    if (bits < 28) {
+        return 0;
+    } else if (bits < 36) {
+        return 1;
+    } else if (bits < 60) {
+        return 2;
+    } else if (bits < 80) {
+        return 3;
+    }
+    return 4;
+}
+
+} // namespace
+
+PasswordAudit::PasswordAudit(QObject *parent)
+    : QAbstractListModel(parent)
+    , mStore(PasswordsModel::passwordStore())
+{
+    std::array<quint32, 8> key;
+    QRandomGenerator::system()->generate(key.begin(), key.end());
+    mHashKey = QByteArray(reinterpret_cast<const char *>(key.data()), sizeof(key));
+}
+
+PasswordAudit::~PasswordAudit()
+{
+    DecryptionService::instance()->cancel(this);
+}
+
+QString PasswordAudit::folder() const
+{
+    return mFolder;
+}
+
+void PasswordAudit::setFolder(const QString &folder)
+{
+    if (mFolder != folder) {
+        mFolder = folder;
+        Q_EMIT folderChanged();
+    }
+}
+
+bool PasswordAudit::isRunning() const
+{
+    return mRunning;
+}
+
+int PasswordAudit::total() const
+{
+    return mTotal;
+}
+
+int PasswordAudit::done() const
+{
+    return mDone;
+}
+
+int PasswordAudit::weakCount() const
+{
+    return static_cast<int>(std::count_if(mResults.cbegin(), mResults.cend(), [](const Result &result) {
+        return result.error.isNull() && result.strength < weakStrength;
+    }));
+}
+
+int PasswordAudit::reusedCount() const
+{
+    qsizetype count = 0;
+    for (const auto &rows : mHashRows) {
+        if (rows.size() > 1) {
+            count += rows.size();
+        }
+    }
+    return static_cast<int>(count);
+}
+
+int PasswordAudit::missingOtpCount() const
+{
+    return static_cast<int>(std::count_if(mResults.cbegin(), mResults.cend(), [](const Result &result) {
+        return result.error.isNull() && !result.hasOtp;
+    }));
+}
+
+int PasswordAudit::failedCount() const
+{
+    return static_cast<int>(std::count_if(mResults.cbegin(), mResults.cend(), [](const Result &result) {
+        return !result.error.isNull();
+    }));
+}
+
+QHash<int, QByteArray> PasswordAudit::roleNames() const
+{
+    return {
+        {FullNameRole, "fullName"},
+        {StrengthRole, "strength"},
+        {ReusedRole, "reused"},
+        {HasOTPRole, "hasOtp"},
+        {ErrorRole, "error"},
+    };
+}
+
+int PasswordAudit::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(mResults.size());
+}
+
+QVariant PasswordAudit::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid)) {
+        return {};
+    }
+
+    const auto &result = mResults[index.row()];
+    switch (role) {
+    case FullNameRole:
+        return result.fullName;
+    case StrengthRole:
+        return result.strength;
+    case ReusedRole:
+        return result.passwordHash.isEmpty() ? 0 : static_cast<int>(mHashRows.value(result.passwordHash).size()) - 1;
+    case HasOTPRole:
+        return result.hasOtp;
+    case ErrorRole:
+        return result.error;
+    }
+    return {};
+}
+
+void PasswordAudit::start()
+{
+    if (mRunning) {
+        return;
+    }
+
+    pruneResults();
+
+    mPending.clear();
+    const auto root = mFolder.isEmpty() ? mStore.absolutePath() : mStore.absoluteFilePath(mFolder);
+    QDirIterator it(root, {QLatin1Char('*') + passwordFileSuffix}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const auto info = it.fileInfo();
+        auto fullName = mStore.relativeFilePath(info.absoluteFilePath());
+        fullName.chop(passwordFileSuffix.size());
+        const auto modified = info.lastModified().toMSecsSinceEpoch();
+
+        // Resume where the last run stopped, failed entries are tried again
+        const auto row = mRows.constFind(fullName);
+        if (row != mRows.cend() && mResults[*row].modified == modified && mResults[*row].error.isNull()) {
+            continue;
+        }
+        mPending.push_back({fullName, modified});
+    }
+
+    ++mRun;
+    mTotal = static_cast<int>(mPending.size());
+    mDone = 0;
+    Q_EMIT progressChanged();
+    if (mPending.isEmpty()) {
+        return;
+    }
+
+    setRunning(true);
+    startNext();
+}
+
+void PasswordAudit::cancel()
+{
+    // Entries already decrypted may still report back, they belong to the canceled run
+    ++mRun;
+    mPending.clear();
+    DecryptionService::instance()->cancel(this);
+    mRunningDecryptions = 0;
+    setRunning(false);
+}
+
+void PasswordAudit::pruneResults()
+{
+    std::vector<Result> results;
+    results.reserve(mResults.size());
+    std::copy_if(mResults.cbegin(), mResults.cend(), std::back_inserter(results), [this](const Result &result) {
+        return QFileInfo::exists(mStore.absoluteFilePath(result.fullName + passwordFileSuffix));
+    });
+    if (results.size() == mResults.size()) {
+        return;
+    }
+
+    beginResetModel();
+    mResults = std::move(results);
+    mRows.clear();
+    mHashRows.clear();
+    for (int row = 0; row < static_cast<int>(mResults.size()); ++row) {
+        mRows.insert(mResults[row].fullName, row);
+        if (!mResults[row].passwordHash.isEmpty()) {
+            mHashRows[mResults[row].passwordHash].push_back(row);
+        }
+    }
+    endResetModel();
+    Q_EMIT resultsChanged();
+}
+
+void PasswordAudit::startNext()
+{
+    while (mRunning && mRunningDecryptions < maxRunningDecryptions && !mPending.isEmpty()) {
+        const auto [fullName, modified] = mPending.takeFirst();
+        auto audit = std::make_shared<Audit>();
+        ++mRunningDecryptions;
+        // The returned entry is not kept, the plain text is dropped as soon as the decryption finishes
+        DecryptionService::instance()->decrypt(
+            mStore.absoluteFilePath(fullName + passwordFileSuffix),
+            this,
+            [this, audit](QStringView line) {
+                if (std::exchange(audit->firstLine, false)) {
+                    auto password = line.toUtf8();
+                    audit->passwordHash = QMessageAuthenticationCode::hash(password, mHashKey, QCryptographicHash::Sha256);
+                    audit->strength = estimateStrength(line);
+                    password.fill('\0');
+                } else if (line.trimmed().startsWith(otpAuthSchema)) {
+                    audit->hasOtp = true;
+                }
+                return false; // the OTP secret may be on any line
+            },
+            [this, run = mRun, fullName, modified](const QString &error) {
+                if (run == mRun) {
+                    finishEntry(fullName, modified, {}, error);
+                }
+            },
+            [this, run = mRun, fullName, modified, audit]() {
+                if (run == mRun) {
+                    finishEntry(fullName, modified, *audit, {});
+                }
+            },
+            DecryptionService::RequestKind::Batch);
+    }
+
+    if (mRunningDecryptions == 0 && mPending.isEmpty()) {
+        setRunning(false);
+    }
+}
+
+void PasswordAudit::finishEntry(const QString &fullName, qint64 modified, const Audit &audit, const QString &error)
+{
+    --mRunningDecryptions;
+    ++mDone;
+
+    Result result{fullName, modified};
+    if (error.isNull()) {
+        result.passwordHash = audit.passwordHash;
+        result.strength = audit.strength;
+        result.hasOtp = audit.hasOtp;
+    } else {
+        qCDebug(PLASMAPASS_LOG, "Failed to audit %s: %s", qUtf8Printable(fullName), qUtf8Printable(error));
+        result.error = error;
+    }
+    setResult(std::move(result));
+
+    Q_EMIT progressChanged();
+    Q_EMIT resultsChanged();
+    startNext();
+}
+
+void PasswordAudit::setResult(Result result)
+{
+    const auto passwordHash = result.passwordHash;
+    int row = 0;
+    const auto it = mRows.constFind(result.fullName);
+    if (it == mRows.cend()) {
+        row = static_cast<int>(mResults.size());
+        beginInsertRows({}, row, row);
+        mRows.insert(result.fullName, row);
+        mResults.push_back(std::move(result));
+        endInsertRows();
+    } else {
+        row = *it;
+        const auto oldHash = std::exchange(mResults[row], std::move(result)).passwordHash;
+        Q_EMIT dataChanged(index(row), index(row));
+        if (!oldHash.isEmpty()) {
+            auto &rows = mHashRows[oldHash];
+            rows.removeOne(row);
+            if (rows.isEmpty()) {
+                mHashRows.remove(oldHash);
+            } else {
+                updateReused(oldHash);
+            }
+        }
+    }
+
+    if (!passwordHash.isEmpty()) {
+        mHashRows[passwordHash].push_back(row);
+        updateReused(passwordHash);
+    }
+}
+
+void PasswordAudit::updateReused(const QByteArray &passwordHash)
+{
+    const auto rows = mHashRows.value(passwordHash);
+    // A single row is not reused, but it may have been until now
+    for (const auto row : rows) {
+        Q_EMIT dataChanged(index(row), index(row), {ReusedRole});
+    }
+}
+
+void PasswordAudit::setRunning(bool running)
+{
+    if (mRunning != running) {
+        mRunning = running;
+        Q_EMIT runningChanged();
+    }
+}
+
+#include "moc_passwordaudit.cpp"
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef PASSWORDAUDIT_H_
+#define PASSWORDAUDIT_H_
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QDir>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include <vector>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Checks all entries of the store, or of a folder, for weak and reused passwords.
+ *
+ * The entries are decrypted through the DecryptionService, at most a few at a time so
+ * that entries the user copies in the meantime don't wait for the whole audit. Only
+ * figures derived from the plain text are kept: a keyed hash of the password (the key
+ * is random and lives only as long as the audit), an estimate of its strength and
+ * whether the entry has an OTP secret.
+ *
+ * Each row is one audited entry. Canceling keeps the results, the next start() only
+ * audits the entries that have not been audited yet, have changed since or failed.
+ */
+class PasswordAudit : public QAbstractListModel
+{
+    Q_OBJECT
+
+    /**
+     * Folder to audit, relative to the password store. The whole store when empty.
+     */
+    Q_PROPERTY(QString folder READ folder WRITE setFolder NOTIFY folderChanged)
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    /**
+     * Number of entries to audit in the current (or last) run and how many of them are done.
+     */
+    Q_PROPERTY(int total READ total NOTIFY progressChanged)
+    Q_PROPERTY(int done READ done NOTIFY progressChanged)
+
+    Q_PROPERTY(int weakCount READ weakCount NOTIFY resultsChanged)
+    Q_PROPERTY(int reusedCount READ reusedCount NOTIFY resultsChanged)
+    Q_PROPERTY(int missingOtpCount READ missingOtpCount NOTIFY resultsChanged)
+    Q_PROPERTY(int failedCount READ failedCount NOTIFY resultsChanged)
+
+public:
+    enum Roles {
+        FullNameRole = Qt::DisplayRole,
+        /**
+         * Rough strength of the password from 0 (very weak) to 4 (very strong).
+         */
+        StrengthRole = Qt::UserRole,
+        /**
+         * Number of other audited entries with the same password.
+         */
+        ReusedRole,
+        HasOTPRole,
+        /**
+         * Why the entry could not be audited, empty when it was.
+         */
+        ErrorRole,
+    };
+
+    explicit PasswordAudit(QObject *parent = nullptr);
+    ~PasswordAudit() override;
+
+    QString folder() const;
+    void setFolder(const QString &folder);
+
+    bool isRunning() const;
+    int total() const;
+    int done() const;
+
+    int weakCount() const;
+    int reusedCount() const;
+    int missingOtpCount() const;
+    int failedCount() const;
+
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    /**
+     * @brief Starts auditing the entries of folder() that have no up-to-date result yet.
+     */
+    Q_INVOKABLE void start();
+    /**
+     * @brief Stops the audit, the results so far are kept.
+     */
+    Q_INVOKABLE void cancel();
+
+Q_SIGNALS:
+    void folderChanged();
+    void runningChanged();
+    void progressChanged();
+    void resultsChanged();
+
+private:
+    struct Result {
+        QString fullName;
+        qint64 modified = 0; // msecs since epoch
+        QByteArray passwordHash;
+        int strength = 0;
+        bool hasOtp = false;
+        QString error;
+    };
+    // Derived figures of the entry being decrypted, filled in line by line
+    struct Audit {
+        QByteArray passwordHash;
+        int strength = 0;
+        bool hasOtp = false;
+        bool firstLine = true;
+    };
+
+    void pruneResults();
+    void startNext();
+    void finishEntry(const QString &fullName, qint64 modified, const Audit &audit, const QString &error);
+    void setResult(Result result);
+    void updateReused(const QByteArray &passwordHash);
+    void setRunning(bool running);
+
+    QDir mStore;
+    QString mFolder;
+    QByteArray mHashKey;
+    std::vector<Result> mResults;
+    // Row of each entry in mResults
+    QHash<QString, int> mRows;
+    // Rows of the entries with the same password hash
+    QHash<QByteArray, QList<int>> mHashRows;
+    // Entries waiting to be audited and their modification times
+    QList<std::pair<QString, qint64>> mPending;
+    int mRunningDecryptions = 0;
+    // Tells results of the current run from those of canceled ones
+    quint64 mRun = 0;
+    int mTotal = 0;
+    int mDone = 0;
+    bool mRunning = false;
+};
+
+}
+
+#endif // PASSWORDAUDIT_H_
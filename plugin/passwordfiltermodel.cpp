@@ -4,100 +4,123 @@
 
 #include "passwordfiltermodel.h"
 #include "abbreviations.h"
+#include "metadataindex.h"
+#include "passwordlistmodel.h"
+#include "parallelchunks.h"
 #include "passwordsmodel.h"
+#include "plasmapass_debug.h"
+#include "usagestore.h"
 
-#include <KDescendantsProxyModel>
-
+#include <QAbstractProxyModel>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
+#include <QThread>
 #include <QtConcurrent>
 
+#include <algorithm>
 #include <chrono>
-#include <iterator>
 
 using namespace PlasmaPass;
+using namespace std::chrono;
+using namespace std::chrono_literals;
 
 namespace
 {
-constexpr const auto invalidateDelay = std::chrono::milliseconds(100);
+// Filtering that is expected to take less than this is done synchronously on every keystroke
+constexpr const auto synchronousUpdateBudget = 4ms;
+// Filtering that is expected to take longer than this is never done synchronously, we
+// always wait for the worker instead of blocking the input
+constexpr const auto frameBudget = 16ms;
+// Bounds of how long to wait for the worker before filtering synchronously
+constexpr const auto minimumInvalidateDelay = 10ms;
+constexpr const auto invalidateDelay = 100ms;
+// Typo-tolerant matches are only shown when the query has fewer regular matches than this
+constexpr const int minimumExactMatches = 5;
+// Matches in the MetadataIndex fields rank below matches in the path, but above typos
+constexpr const int fieldMatchQuality = FuzzyMatchQuality / 2;
 constexpr const char *newFilterProperty = "newFilter";
-
-class ModelIterator
+// Memory used by the results of recent queries, and how many of them are kept at most
+constexpr const qsizetype lookupCacheSize = 16 * 1024 * 1024;
+constexpr const qsizetype lookupCacheEntries = 32;
+// Updates that need more separate removals, moves and insertions than this are done
+// as a reset, each of the changes moves the tail of the rows and notifies the views
+constexpr const int maxIncrementalChanges = 256;
+// Prefixes of filters that are patterns rather than paths
+constexpr const QLatin1StringView regexPrefix("re:");
+constexpr const QLatin1StringView globPrefix("glob:");
+
+// Exponential moving average of the measured costs
+void updateCost(std::optional<microseconds> &cost, microseconds sample)
 {
-public:
-    using reference = const QModelIndex &;
-    using pointer = QModelIndex *;
-    using value_type = QModelIndex;
-    using difference_type = int;
-    using iterator_category = std::forward_iterator_tag;
-
-    static ModelIterator begin(QAbstractItemModel *model)
-    {
-        return ModelIterator{model, model->index(0, 0)};
-    }
-
-    static ModelIterator end(QAbstractItemModel *model)
-    {
-        return ModelIterator{model, {}};
-    }
-
-    bool operator==(const ModelIterator &other) const
-    {
-        return mModel == other.mModel && mIndex == other.mIndex;
-    }
-
-    bool operator!=(const ModelIterator &other) const
-    {
-        return !(*this == other);
-    }
+    cost = cost.has_value() ? (*cost * 3 + sample) / 4 : sample;
+}
 
-    QModelIndex operator*() const
-    {
-        return mIndex;
-    }
+bool isPatternFilter(const QString &filter)
+{
+    return filter.startsWith(regexPrefix) || filter.startsWith(globPrefix);
+}
 
-    const QModelIndex *operator->() const
-    {
-        return &mIndex;
-    }
+// Path filters give the same results regardless of case, but the case matters in
+// patterns, e.g. "\d" and "\D" are not the same
+QString lookupCacheKey(const QString &filter)
+{
+    return isPatternFilter(filter) ? filter : filter.toCaseFolded();
+}
 
-    ModelIterator &operator++()
-    {
-        if (mIndex.row() < mModel->rowCount() - 1) {
-            mIndex = mModel->index(mIndex.row() + 1, mIndex.column());
+// Marks the values that form the longest strictly increasing subsequence of values
+std::vector<bool> longestIncreasingSubsequence(const std::vector<int> &values)
+{
+    // tails[n] is the index of the smallest value that ends an increasing subsequence of length n + 1
+    std::vector<int> tails;
+    std::vector<int> previous(values.size(), -1);
+    for (int i = 0; i < static_cast<int>(values.size()); ++i) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), values[i], [&values](int index, int value) {
+            return values[index] < value;
+        });
+        if (it != tails.begin()) {
+            previous[i] = *(it - 1);
+        }
+        if (it == tails.end()) {
+            tails.push_back(i);
         } else {
-            mIndex = {};
+            *it = i;
         }
-        return *this;
     }
 
-    ModelIterator operator++(int)
-    {
-        ModelIterator it = *this;
-        ++*this;
-        return it;
+    std::vector<bool> result(values.size(), false);
+    for (int i = tails.empty() ? -1 : tails.back(); i != -1; i = previous[i]) {
+        result[i] = true;
     }
-
-private:
-    ModelIterator(QAbstractItemModel *model, const QModelIndex &index)
-        : mModel(model)
-        , mIndex(index)
-    {
-    }
-
-private:
-    QAbstractItemModel *mModel = nullptr;
-    QModelIndex mIndex;
-};
+    return result;
+}
 
 } // namespace
 
-PasswordFilterModel::PathFilter::PathFilter(QString filter)
+PasswordFilterModel::PathFilter::PathFilter(QString filter,
+                                            QStringList names,
+                                            QList<QList<int>> positions,
+                                            QList<QByteArray> latin1Names,
+                                            QStringList foldedNames,
+                                            QStringList foldedFields)
     : filter(std::move(filter))
+    , names(std::move(names))
+    , positions(std::move(positions))
+    , latin1Names(std::move(latin1Names))
+    , foldedNames(std::move(foldedNames))
+    , foldedFields(std::move(foldedFields))
 {
+    updateParts();
 }
 
 PasswordFilterModel::PathFilter::PathFilter(const PathFilter &other)
     : filter(other.filter)
+    , names(other.names)
+    , positions(other.positions)
+    , latin1Names(other.latin1Names)
+    , foldedNames(other.foldedNames)
+    , foldedFields(other.foldedFields)
+    , mRegex(other.mRegex)
+    , mRegexFilter(other.mRegexFilter)
 {
     updateParts();
 }
@@ -105,12 +128,26 @@ PasswordFilterModel::PathFilter::PathFilter(const PathFilter &other)
 PasswordFilterModel::PathFilter &PasswordFilterModel::PathFilter::operator=(const PathFilter &other)
 {
     filter = other.filter;
+    names = other.names;
+    positions = other.positions;
+    latin1Names = other.latin1Names;
+    foldedNames = other.foldedNames;
+    foldedFields = other.foldedFields;
+    mRegex = other.mRegex;
+    mRegexFilter = other.mRegexFilter;
     updateParts();
     return *this;
 }
 
 PasswordFilterModel::PathFilter::PathFilter(PathFilter &&other) noexcept
     : filter(std::move(other.filter))
+    , names(std::move(other.names))
+    , positions(std::move(other.positions))
+    , latin1Names(std::move(other.latin1Names))
+    , foldedNames(std::move(other.foldedNames))
+    , foldedFields(std::move(other.foldedFields))
+    , mRegex(std::move(other.mRegex))
+    , mRegexFilter(std::move(other.mRegexFilter))
 {
     updateParts();
 }
@@ -118,43 +155,168 @@ PasswordFilterModel::PathFilter::PathFilter(PathFilter &&other) noexcept
 PasswordFilterModel::PathFilter &PasswordFilterModel::PathFilter::operator=(PathFilter &&other) noexcept
 {
     filter = std::move(other.filter);
+    names = std::move(other.names);
+    positions = std::move(other.positions);
+    latin1Names = std::move(other.latin1Names);
+    foldedNames = std::move(other.foldedNames);
+    foldedFields = std::move(other.foldedFields);
+    mRegex = std::move(other.mRegex);
+    mRegexFilter = std::move(other.mRegexFilter);
     updateParts();
     return *this;
 }
 
 void PasswordFilterModel::PathFilter::updateParts()
 {
-    mParts = QStringView(filter).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    mPatternMatching = isPatternFilter(filter);
+    if (mPatternMatching) {
+        if (mRegexFilter != filter) {
+            const bool regex = filter.startsWith(regexPrefix);
+            // The names are matched without their diacritics, so the pattern must not have them either
+            const auto pattern = normalizeForMatching(filter.sliced(regex ? regexPrefix.size() : globPrefix.size()));
+            mRegex = regex ? QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption) : QRegularExpression::fromWildcard(pattern, Qt::CaseInsensitive);
+            // Compile the pattern, with JIT where available, once here rather than on the
+            // first match in each of the workers
+            mRegex.optimize();
+            mRegexFilter = filter;
+        }
+        mFoldedFilter.clear();
+        mParts.clear();
+        mLatin1Filter.clear();
+        mLatin1Parts.clear();
+        mFuzzyMatcher = FuzzyMatcher{};
+        return;
+    }
+
+    // All matching is case-insensitive, so it is done with the case-folded filter. That
+    // way the results depend only on the folded filter, which is what they are cached by.
+    // The diacritics are removed from the filter the same way they are from the names.
+    mFoldedFilter = normalizeForMatching(filter).toCaseFolded();
+    mParts = QStringView(mFoldedFilter).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+
+    // The parts view into mLatin1Filter, so it must not be modified afterwards
+    if (!latin1Names.isEmpty() && isLatin1(mFoldedFilter)) {
+        mLatin1Filter = mFoldedFilter.toLatin1();
+        mLatin1Parts = splitPath(QLatin1StringView(mLatin1Filter), Qt::SkipEmptyParts);
+    } else {
+        mLatin1Filter.clear();
+        mLatin1Parts.clear();
+    }
+
+    const int maxErrors = FuzzyMatcher::errorsForLength(mFoldedFilter.size());
+    if (foldedNames.isEmpty() || maxErrors == 0) {
+        mFuzzyMatcher = FuzzyMatcher{};
+    } else {
+        mFuzzyMatcher = FuzzyMatcher(mFoldedFilter, maxErrors);
+    }
 }
 
-PasswordFilterModel::PathFilter::result_type PasswordFilterModel::PathFilter::operator()(const QModelIndex &index) const
+int PasswordFilterModel::PathFilter::operator()(int row, MatchRanges *ranges) const
 {
-    const auto path = index.model()->data(index, PasswordsModel::FullNameRole).toString();
-    const auto weight = matchPathFilter(QStringView(path).split(QLatin1Char('/')), mParts);
-    return std::make_pair(index, weight);
+    if (ranges != nullptr) {
+        ranges->clear();
+    }
+    if (row >= names.size()) {
+        return -1;
+    }
+
+    if (mPatternMatching) {
+        // Patterns are often invalid while they are being typed, those match nothing
+        if (!mRegex.isValid()) {
+            return -1;
+        }
+        const auto match = mRegex.match(names.at(row));
+        if (!match.hasMatch()) {
+            return -1;
+        }
+        if (ranges != nullptr && match.capturedLength() > 0) {
+            ranges->push_back(static_cast<quint32>(match.capturedStart()) << 16 | static_cast<quint32>(match.capturedLength()));
+            if (row < positions.size()) {
+                mapRanges(*ranges, positions.at(row));
+            }
+        }
+        // All matches are equally good, they are sorted by usage and name
+        return 0;
+    }
+
+    int weight = -1;
+    if (!mLatin1Parts.isEmpty() && row < latin1Names.size() && !latin1Names.at(row).isNull()) {
+        weight = matchPathFilter(splitPath(QLatin1StringView(latin1Names.at(row))), mLatin1Parts, ranges);
+    } else {
+        weight = matchPathFilter(QStringView(names.at(row)).split(QLatin1Char('/')), mParts, ranges);
+    }
+    if (weight > -1 && ranges != nullptr && row < positions.size()) {
+        mapRanges(*ranges, positions.at(row));
+    }
+    if (weight == -1 && !mFoldedFilter.isEmpty() && row < foldedFields.size() && foldedFields.at(row).contains(mFoldedFilter)) {
+        weight = fieldMatchQuality;
+    }
+    if (weight == -1 && mFuzzyMatcher.isValid() && row < foldedNames.size()) {
+        const int errors = mFuzzyMatcher.match(foldedNames.at(row));
+        if (errors != -1) {
+            weight = FuzzyMatchQuality + errors;
+        }
+    }
+    return weight;
 }
 
 PasswordFilterModel::PasswordFilterModel(QObject *parent)
-    : QSortFilterProxyModel(parent)
-    , mFlatModel(new KDescendantsProxyModel(this))
+    : QAbstractProxyModel(parent)
+    , mFlatModel(new PasswordListModel(this))
+    , mLookupCache(lookupCacheSize)
 {
-    mFlatModel->setDisplayAncestorData(false);
-    sort(0); // enable sorting
+    // The row cache is indexed by source row, so drop it whenever the rows may move.
+    // The rows are filtered again from the handler of modelReset, so the cache must be
+    // marked stale already in the "about to" signals.
+    connect(mFlatModel, &QAbstractItemModel::modelAboutToBeReset, this, &PasswordFilterModel::invalidateRowCache);
+    connect(mFlatModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &PasswordFilterModel::invalidateRowCache);
+    connect(mFlatModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &PasswordFilterModel::invalidateRowCache);
+    connect(mFlatModel, &QAbstractItemModel::rowsAboutToBeMoved, this, &PasswordFilterModel::invalidateRowCache);
+    connect(mFlatModel, &QAbstractItemModel::layoutAboutToBeChanged, this, &PasswordFilterModel::invalidateRowCache);
+    // The flat model only ever resets, it is rebuilt whenever the store changes
+    connect(mFlatModel, &QAbstractItemModel::modelAboutToBeReset, this, &PasswordFilterModel::beginResetModel);
+    connect(mFlatModel, &QAbstractItemModel::modelReset, this, [this]() {
+        mRows = acceptedRows();
+        mProxyRowsDirty = true;
+        endResetModel();
+    });
+    connect(UsageStore::instance(), &UsageStore::usageChanged, this, [this]() {
+        mUsageDirty = true;
+    });
+    connect(MetadataIndex::instance(), &MetadataIndex::indexChanged, this, [this]() {
+        if (mSearchMetadata) {
+            mFieldsDirty = true;
+            mLookupCache.clear();
+            rerunFilter();
+        }
+    });
+    // Let the index pick up new and modified entries
+    connect(mFlatModel, &QAbstractItemModel::modelReset, this, [this]() {
+        if (mSearchMetadata) {
+            MetadataIndex::instance()->update();
+        }
+    });
+
+    QAbstractProxyModel::setSourceModel(mFlatModel);
 
     mUpdateTimer.setSingleShot(true);
     connect(&mUpdateTimer, &QTimer::timeout, this, &PasswordFilterModel::delayedUpdateFilter);
-    connect(&mUpdateTimer, &QTimer::timeout, this, []() {
-        qDebug() << "Update timer timeout, will calculate results lazily.";
-    });
 }
 
 void PasswordFilterModel::setSourceModel(QAbstractItemModel *sourceModel)
 {
-    mFlatModel->setSourceModel(sourceModel);
-
-    if (this->sourceModel() == nullptr) {
-        QSortFilterProxyModel::setSourceModel(mFlatModel);
+    // Searching goes over the flat list of all entries, so only the PasswordsModel
+    // is needed, not any of the proxies on top of it
+    auto model = sourceModel;
+    while (auto proxy = qobject_cast<QAbstractProxyModel *>(model)) {
+        model = proxy->sourceModel();
     }
+    auto passwordsModel = qobject_cast<PasswordsModel *>(model);
+    if (sourceModel != nullptr && passwordsModel == nullptr) {
+        qCWarning(PLASMAPASS_LOG, "PasswordFilterModel requires a PasswordsModel as its source");
+    }
+    mFlatModel->setPasswordsModel(passwordsModel);
+    mLookupCache.clear();
 }
 
 QString PasswordFilterModel::passwordFilter() const
@@ -164,96 +326,633 @@ QString PasswordFilterModel::passwordFilter() const
 
 void PasswordFilterModel::setPasswordFilter(const QString &filter)
 {
-    if (mFilter.filter != filter) {
-        if (mUpdateTimer.isActive()) {
-            mUpdateTimer.stop();
-        }
+    if (filter == mUpdateTimer.property(newFilterProperty).toString()) {
+        return;
+    }
+
+    mUpdateTimer.stop();
+    mUpdateTimer.setProperty(newFilterProperty, filter);
+    mWaitingForWorker = false;
+    if (mFuture.isRunning()) {
+        mFuture.cancel();
+    }
 
-        mUpdateTimer.setProperty(newFilterProperty, filter);
-        mUpdateTimer.start(invalidateDelay);
+    // Reuse the results of a recent query, this makes backspacing and retyping instant
+    if (!filter.isEmpty() && restoreLookup(filter)) {
+        delayedUpdateFilter();
+        return;
+    }
+
+    // Small stores are filtered faster than it would take to hand the work over to
+    // a worker, so just do it right away.
+    if (filter.isEmpty() || (mSyncCost.has_value() && *mSyncCost <= synchronousUpdateBudget)) {
+        delayedUpdateFilter();
+        return;
+    }
 
-        if (mFuture.isRunning()) {
-            mFuture.cancel();
+    ensureRowCache();
+    QElapsedTimer workerTimer;
+    workerTimer.start();
+    mFuture = QtConcurrent::run(
+        [](QPromise<Lookup> &promise, const PathFilter &pathFilter, std::pair<int, int> range) {
+            auto lookup = computeLookup(pathFilter, range, &promise);
+            if (!promise.isCanceled()) {
+                promise.addResult(std::move(lookup));
+            }
+        },
+        createPathFilter(filter),
+        searchRange());
+    auto watcher = new QFutureWatcher<Lookup>();
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, filter, workerTimer]() {
+        watcher->deleteLater();
+        // Ignore results of a query that has been superseded or calculated synchronously already
+        if (watcher->isCanceled() || watcher->resultCount() == 0 || filter != mUpdateTimer.property(newFilterProperty).toString() || mSortingLookupFilter == filter) {
+            return;
         }
-        if (!filter.isEmpty()) {
-            mFuture = QtConcurrent::mappedReduced<QHash<QModelIndex, int>>(ModelIterator::begin(sourceModel()),
-                                                                           ModelIterator::end(sourceModel()),
-                                                                           PathFilter{filter},
-                                                                           [](QHash<QModelIndex, int> &result, const std::pair<QModelIndex, int> &value) {
-                                                                               result.insert(value.first, value.second);
-                                                                           });
-            auto watcher = new QFutureWatcher<QHash<QModelIndex, int>>();
-            connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
-                mSortingLookup = mFuture.result();
-                watcher->deleteLater();
-                // If the timer is not active it means we were to slow, so don't invoke
-                // delayedUpdateFilter() again, just update mSortingLookup with our
-                // results.
-                if (mUpdateTimer.isActive()) {
-                    mUpdateTimer.stop();
-                    delayedUpdateFilter();
-                }
-            });
-            connect(watcher, &QFutureWatcherBase::canceled, watcher, &QObject::deleteLater);
-            watcher->setFuture(mFuture);
+        mLastWorkerCost = duration_cast<microseconds>(nanoseconds(workerTimer.nsecsElapsed()));
+        updateCost(mWorkerCost, mLastWorkerCost);
+
+        setLookup(filter, watcher->future().takeResult());
+        mLookupFromWorker = true;
+        if (mUpdateTimer.isActive() || mWaitingForWorker) {
+            mUpdateTimer.stop();
+            mWaitingForWorker = false;
+            delayedUpdateFilter();
         }
+    });
+    watcher->setFuture(mFuture);
+
+    if (!mSyncCost.has_value() || *mSyncCost <= frameBudget) {
+        // Give the worker as much time as it usually needs, then do it ourselves
+        const auto delay = mWorkerCost.has_value() ? std::clamp<milliseconds>(duration_cast<milliseconds>(*mWorkerCost * 2), minimumInvalidateDelay, invalidateDelay)
+                                                   : invalidateDelay;
+        mUpdateTimer.start(delay);
+    } else {
+        // Filtering synchronously would block the input, just wait for the worker
+        mWaitingForWorker = true;
+    }
+}
+
+bool PasswordFilterModel::fuzzyMatching() const
+{
+    return mFuzzyMatching;
+}
+
+void PasswordFilterModel::setFuzzyMatching(bool fuzzyMatching)
+{
+    if (mFuzzyMatching != fuzzyMatching) {
+        mFuzzyMatching = fuzzyMatching;
+        Q_EMIT fuzzyMatchingChanged();
+        mLookupCache.clear();
+
+        rerunFilter();
     }
 }
 
+bool PasswordFilterModel::searchMetadata() const
+{
+    return mSearchMetadata;
+}
+
+void PasswordFilterModel::setSearchMetadata(bool searchMetadata)
+{
+    if (mSearchMetadata != searchMetadata) {
+        mSearchMetadata = searchMetadata;
+        MetadataIndex::instance()->setEnabled(searchMetadata);
+        mFieldsDirty = true;
+        Q_EMIT searchMetadataChanged();
+        mLookupCache.clear();
+
+        rerunFilter();
+    }
+}
+
+QModelIndex PasswordFilterModel::searchRoot() const
+{
+    return mSearchRoot;
+}
+
+void PasswordFilterModel::setSearchRoot(const QModelIndex &searchRoot)
+{
+    // Map the index down to the PasswordsModel, the entry ranges are only known there
+    auto index = searchRoot;
+    while (auto proxy = qobject_cast<const QAbstractProxyModel *>(index.model())) {
+        index = proxy->mapToSource(index);
+    }
+    if (index.isValid() && index.model() != mFlatModel->passwordsModel()) {
+        qCWarning(PLASMAPASS_LOG, "Search root does not belong to the source model");
+        index = {};
+    }
+
+    if (mSearchRoot == index) {
+        return;
+    }
+
+    mSearchRoot = index;
+    Q_EMIT searchRootChanged();
+    mLookupCache.clear();
+
+    if (mUpdateTimer.property(newFilterProperty).toString().isEmpty()) {
+        updateRows();
+    } else {
+        rerunFilter();
+    }
+}
+
+void PasswordFilterModel::resetSearchRoot()
+{
+    setSearchRoot({});
+}
+
+std::pair<int, int> PasswordFilterModel::searchRange() const
+{
+    const auto passwordsModel = mFlatModel->passwordsModel();
+    if (passwordsModel == nullptr) {
+        return {0, 0};
+    }
+    if (!mSearchRoot.isValid()) {
+        return {0, passwordsModel->entryCount()};
+    }
+    return passwordsModel->entryRange(mSearchRoot);
+}
+
+void PasswordFilterModel::rerunFilter()
+{
+    const auto filter = mUpdateTimer.property(newFilterProperty).toString();
+    if (!filter.isEmpty()) {
+        mSortingLookupFilter.clear();
+        mUpdateTimer.setProperty(newFilterProperty, QString());
+        setPasswordFilter(filter);
+    }
+}
+
+PasswordFilterModel::PathFilter PasswordFilterModel::createPathFilter(const QString &filter) const
+{
+    if (filter.isEmpty()) {
+        return PathFilter{filter};
+    }
+
+    ensureRowCache();
+    return PathFilter{filter,
+                      mNames,
+                      mPositions,
+                      mLatin1Names,
+                      mFuzzyMatching ? mFoldedNames : QStringList{},
+                      mSearchMetadata ? mFoldedFields : QStringList{}};
+}
+
 void PasswordFilterModel::delayedUpdateFilter()
 {
-    mFilter = PathFilter(mUpdateTimer.property(newFilterProperty).toString());
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto filter = mUpdateTimer.property(newFilterProperty).toString();
+    mFilter = createPathFilter(filter);
     Q_EMIT passwordFilterChanged();
-    if (mFuture.isRunning()) {
-        // If the future is still running, clear up the lookup table, we will have to
-        // calculate the intermediate results ourselves
-        mSortingLookup.clear();
+    bool computed = false;
+    if (filter.isEmpty()) {
+        mSortingLookup = {};
+        mSortingLookupFilter.clear();
+    } else if (mSortingLookupFilter != filter) {
+        // The worker did not make it in time, calculate the results ourselves. All rows
+        // are needed anyway, to decide whether typo-tolerant matches should be shown.
+        mFuture.cancel();
+        setLookup(filter, computeLookup(mFilter, searchRange()));
+        computed = true;
     }
-    invalidate();
+    updateRows();
+    // Rows that were accepted before keep their delegates, so tell them about their new ranges
+    if (rowCount() > 0) {
+        Q_EMIT dataChanged(index(0, 0), index(rowCount() - 1, 0), {PasswordsModel::MatchRangesRole});
+    }
+
+    const auto elapsed = duration_cast<microseconds>(nanoseconds(timer.nsecsElapsed()));
+    if (computed) {
+        updateCost(mSyncCost, elapsed);
+    } else if (mLookupFromWorker) {
+        // The worker did the matching, estimate what it would have cost us to do it here
+        updateCost(mSyncCost, mLastWorkerCost * QThread::idealThreadCount() + elapsed);
+    }
+    mLookupFromWorker = false;
 }
 
-QVariant PasswordFilterModel::data(const QModelIndex &index, int role) const
+PasswordFilterModel::Lookup PasswordFilterModel::computeLookup(const PathFilter &filter, std::pair<int, int> range, QPromise<Lookup> *promise)
 {
-    if (role == Qt::DisplayRole) {
-        return data(index, PasswordsModel::FullNameRole);
+    Lookup lookup;
+    const int rows = static_cast<int>(filter.names.size());
+    lookup.weights.assign(rows, -1);
+    // Only the entries in the searched folder are matched, the rest stays at -1
+    const int first = std::clamp(range.first, 0, rows);
+    const int last = std::clamp(range.second, first, rows);
+    lookup.firstRow = first;
+    lookup.rangeEnds.assign(last - first, 0);
+    lookup.chunkRanges.resize((last - first + DefaultChunkSize - 1) / DefaultChunkSize);
+    // Each chunk writes only its own part of the lookup, so the workers never wait for each other
+    blockingMapChunks(last - first, [&filter, &lookup, promise, first](int chunkFirst, int chunkLast) {
+        if (promise != nullptr && promise->isCanceled()) {
+            return;
+        }
+        auto &buffer = lookup.chunkRanges[chunkFirst / DefaultChunkSize];
+        MatchRanges ranges;
+        for (int i = chunkFirst; i < chunkLast; ++i) {
+            const int weight = filter(first + i, &ranges);
+            lookup.weights[first + i] = weight;
+            if (weight > -1) {
+                buffer.insert(buffer.end(), ranges.cbegin(), ranges.cend());
+            }
+            lookup.rangeEnds[i] = static_cast<quint32>(buffer.size());
+        }
+    });
+    return lookup;
+}
+
+QList<int> PasswordFilterModel::Lookup::ranges(int row) const
+{
+    const auto i = static_cast<std::size_t>(row - firstRow);
+    if (row < firstRow || i >= rangeEnds.size() || weights[row] == -1) {
+        return {};
     }
 
-    return QSortFilterProxyModel::data(index, role);
+    const auto &buffer = chunkRanges[i / DefaultChunkSize];
+    const quint32 begin = i % DefaultChunkSize == 0 ? 0 : rangeEnds[i - 1];
+    QList<int> result;
+    result.reserve(2 * (rangeEnds[i] - begin));
+    for (auto range = begin; range < rangeEnds[i]; ++range) {
+        result << static_cast<int>(buffer[range] >> 16) << static_cast<int>(buffer[range] & 0xFFFF);
+    }
+    return result;
+}
+
+void PasswordFilterModel::ensureLookup() const
+{
+    if (mSortingLookupFilter == mFilter.filter && mSortingLookup.weights.size() == static_cast<std::size_t>(mFlatModel->rowCount())) {
+        return;
+    }
+
+    // The rows have changed since the filter was set, so the filter needs new row data as well
+    setLookup(mFilter.filter, computeLookup(createPathFilter(mFilter.filter), searchRange()));
+}
+
+void PasswordFilterModel::setLookup(const QString &filter, Lookup lookup) const
+{
+    applyFuzzyTier(lookup.weights);
+    mSortingLookup = std::move(lookup);
+    mSortingLookupFilter = filter;
+
+    checkLookupCacheGeneration();
+    qsizetype cost = static_cast<qsizetype>(sizeof(int) * mSortingLookup.weights.size() + sizeof(quint32) * mSortingLookup.rangeEnds.size());
+    for (const auto &chunk : mSortingLookup.chunkRanges) {
+        cost += static_cast<qsizetype>(sizeof(quint32) * chunk.size());
+    }
+    mLookupCache.insert(lookupCacheKey(filter), new CachedLookup{mSortingLookup, mFuzzyTierActive}, std::max(cost, lookupCacheSize / lookupCacheEntries));
 }
 
-bool PasswordFilterModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+bool PasswordFilterModel::restoreLookup(const QString &filter)
 {
-    const auto src_index = sourceModel()->index(source_row, 0, source_parent);
-    const auto type = static_cast<PasswordsModel::EntryType>(sourceModel()->data(src_index, PasswordsModel::EntryTypeRole).toInt());
-    if (type == PasswordsModel::FolderEntry) {
+    checkLookupCacheGeneration();
+    const auto cached = mLookupCache.object(lookupCacheKey(filter));
+    if (cached == nullptr) {
         return false;
     }
 
-    if (mFilter.filter.isEmpty()) {
-        return true;
+    mSortingLookup = cached->lookup;
+    mSortingLookupFilter = filter;
+    mFuzzyTierActive = cached->fuzzyTierActive;
+    return true;
+}
+
+void PasswordFilterModel::checkLookupCacheGeneration() const
+{
+    const auto passwordsModel = mFlatModel->passwordsModel();
+    const auto generation = passwordsModel != nullptr ? passwordsModel->generation() : 0;
+    if (generation != mLookupCacheGeneration) {
+        mLookupCache.clear();
+        mLookupCacheGeneration = generation;
+    }
+}
+
+void PasswordFilterModel::applyFuzzyTier(std::vector<int> &lookup) const
+{
+    const auto exactMatches = std::count_if(lookup.cbegin(), lookup.cend(), [](int weight) {
+        return weight > -1 && weight < FuzzyMatchQuality;
+    });
+    mFuzzyTierActive = exactMatches < minimumExactMatches;
+    if (mFuzzyTierActive) {
+        return;
+    }
+
+    for (auto &weight : lookup) {
+        if (weight >= FuzzyMatchQuality) {
+            weight = -1;
+        }
+    }
+}
+
+void PasswordFilterModel::invalidateRowCache()
+{
+    mRowCacheDirty = true;
+    // The lookup is keyed by rows that are about to become invalid as well
+    mSortingLookup = {};
+    mSortingLookupFilter.clear();
+}
+
+void PasswordFilterModel::ensureRowCache() const
+{
+    if (mRowCacheDirty) {
+        const auto usage = UsageStore::instance();
+        const int rows = mFlatModel->rowCount();
+        mRowCache.clear();
+        mRowCache.reserve(rows);
+        mFullNames = QStringList{};
+        mFullNames.reserve(rows);
+        mNames = QStringList{};
+        mNames.reserve(rows);
+        mPositions = QList<QList<int>>{};
+        mPositions.reserve(rows);
+        // Not cleared in place, a worker may still be holding a shallow copy
+        mFoldedNames = QStringList{};
+        mFoldedNames.reserve(rows);
+        mLatin1Names = QList<QByteArray>{};
+        mLatin1Names.reserve(rows);
+        for (int row = 0; row < rows; ++row) {
+            auto fullName = mFlatModel->fullName(row);
+            auto sortKey = mCollator.sortKey(fullName);
+            const auto score = usage->score(fullName);
+            // Diacritics are removed here once, so that matching costs the same as before
+            QList<int> positions;
+            auto name = normalizeForMatching(fullName, &positions);
+            mFoldedNames.push_back(name.toCaseFolded());
+            // Most names are plain ASCII, those are matched on 8-bit copies
+            mLatin1Names.push_back(isLatin1(name) ? name.toLatin1() : QByteArray{});
+            mNames.push_back(std::move(name));
+            mPositions.push_back(std::move(positions));
+            mRowCache.push_back({std::move(sortKey), score});
+            mFullNames.push_back(std::move(fullName));
+        }
+        mRowCacheDirty = false;
+        mUsageDirty = false;
+        mFieldsDirty = true;
+    } else if (mUsageDirty) {
+        const auto usage = UsageStore::instance();
+        for (std::size_t row = 0; row < mRowCache.size(); ++row) {
+            mRowCache[row].usage = usage->score(mFullNames.at(row));
+        }
+        mUsageDirty = false;
+    }
+
+    if (mFieldsDirty) {
+        // Not cleared in place, a worker may still be holding a shallow copy
+        mFoldedFields = QStringList{};
+        if (mSearchMetadata) {
+            const auto index = MetadataIndex::instance();
+            mFoldedFields.reserve(mFullNames.size());
+            for (const auto &fullName : std::as_const(mFullNames)) {
+                mFoldedFields.push_back(normalizeForMatching(index->fields(fullName)));
+            }
+        }
+        mFieldsDirty = false;
+    }
+}
+
+QModelIndex PasswordFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount()) {
+        return {};
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex PasswordFilterModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child)
+    return {};
+}
+
+int PasswordFilterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(mRows.size());
+}
+
+int PasswordFilterModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+bool PasswordFilterModel::hasChildren(const QModelIndex &parent) const
+{
+    return rowCount(parent) > 0;
+}
+
+QModelIndex PasswordFilterModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || proxyIndex.model() != this || static_cast<std::size_t>(proxyIndex.row()) >= mRows.size()) {
+        return {};
+    }
+    return mFlatModel->index(mRows[proxyIndex.row()], proxyIndex.column());
+}
+
+QModelIndex PasswordFilterModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid() || sourceIndex.model() != mFlatModel) {
+        return {};
     }
 
-    // Try to lookup the weight in the lookup table, the worker thread may have put it in there
-    // while the updateTimer was ticking
-    auto weight = mSortingLookup.find(src_index);
-    if (weight == mSortingLookup.end()) {
-        // It's not there, let's calculate the value now
-        const auto result = mFilter(src_index);
-        weight = mSortingLookup.insert(result.first, result.second);
+    if (mProxyRowsDirty) {
+        mProxyRows.assign(mFlatModel->rowCount(), -1);
+        for (std::size_t i = 0; i < mRows.size(); ++i) {
+            mProxyRows[mRows[i]] = static_cast<int>(i);
+        }
+        mProxyRowsDirty = false;
+    }
+    const auto row = static_cast<std::size_t>(sourceIndex.row());
+    if (row >= mProxyRows.size() || mProxyRows[row] == -1) {
+        return {};
+    }
+    return index(mProxyRows[row], sourceIndex.column());
+}
+
+void PasswordFilterModel::updateRows()
+{
+    applyRows(acceptedRows());
+}
+
+std::vector<int> PasswordFilterModel::acceptedRows() const
+{
+    std::vector<int> rows;
+    const int sourceRows = mFlatModel->rowCount();
+    for (int row = 0; row < sourceRows; ++row) {
+        if (filterAcceptsRow(row)) {
+            rows.push_back(row);
+        }
     }
 
-    return *weight > -1;
+    ensureRowCache();
+    std::sort(rows.begin(), rows.end(), [this](int left, int right) {
+        return lessThan(left, right);
+    });
+    return rows;
 }
 
-bool PasswordFilterModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
+void PasswordFilterModel::applyRows(std::vector<int> rows)
 {
-    const auto weightLeft = mSortingLookup.value(source_left, -1);
-    const auto weightRight = mSortingLookup.value(source_right, -1);
+    const auto sourceRows = static_cast<std::size_t>(mFlatModel->rowCount());
+    // Position of each source row in the new results, -1 for rows that are not in them
+    std::vector<int> newPositions(sourceRows, -1);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        newPositions[rows[i]] = static_cast<int>(i);
+    }
+    std::vector<bool> shown(sourceRows, false);
+    for (const int row : mRows) {
+        shown[row] = true;
+    }
+    const auto isRemoved = [&newPositions](int row) {
+        return newPositions[row] == -1;
+    };
+
+    // Count the changes first, many small changes are better done as a single reset
+    int changes = 0;
+    std::vector<int> keptPositions;
+    for (std::size_t i = 0; i < mRows.size(); ++i) {
+        if (!isRemoved(mRows[i])) {
+            keptPositions.push_back(newPositions[mRows[i]]);
+        } else if (i == 0 || !isRemoved(mRows[i - 1])) {
+            ++changes;
+        }
+    }
+    // The longest run of kept rows that are already in the right order stays in place
+    const auto inOrder = longestIncreasingSubsequence(keptPositions);
+    changes += static_cast<int>(std::count(inOrder.cbegin(), inOrder.cend(), false));
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (!shown[rows[i]] && (i == 0 || shown[rows[i - 1]])) {
+            ++changes;
+        }
+    }
+
+    if (changes > maxIncrementalChanges) {
+        beginResetModel();
+        mRows = std::move(rows);
+        mProxyRowsDirty = true;
+        endResetModel();
+        return;
+    }
+
+    // Remove the rows that are no longer accepted, from the end so that the positions
+    // of the rows before them stay valid
+    for (auto end = static_cast<int>(mRows.size()); end > 0;) {
+        if (!isRemoved(mRows[end - 1])) {
+            --end;
+            continue;
+        }
+        int first = end - 1;
+        while (first > 0 && isRemoved(mRows[first - 1])) {
+            --first;
+        }
+        beginRemoveRows({}, first, end - 1);
+        mRows.erase(mRows.begin() + first, mRows.begin() + end);
+        mProxyRowsDirty = true;
+        endRemoveRows();
+        end = first;
+    }
+
+    // Move each of the remaining rows that is out of order right behind the row that
+    // precedes it in the new results. Going in the new order, the preceding row is
+    // always in its final place already.
+    std::vector<bool> fixed(sourceRows, false);
+    for (std::size_t i = 0; i < mRows.size(); ++i) {
+        fixed[mRows[i]] = inOrder[i];
+    }
+    const auto position = [this](int row) {
+        return static_cast<int>(std::find(mRows.cbegin(), mRows.cend(), row) - mRows.cbegin());
+    };
+    int previous = -1;
+    for (const int row : rows) {
+        if (!shown[row]) {
+            continue;
+        }
+        if (!fixed[row]) {
+            const int from = position(row);
+            const int to = previous == -1 ? 0 : position(previous) + 1;
+            if (to != from) {
+                beginMoveRows({}, from, from, {}, to);
+                if (to > from) {
+                    std::rotate(mRows.begin() + from, mRows.begin() + from + 1, mRows.begin() + to);
+                } else {
+                    std::rotate(mRows.begin() + to, mRows.begin() + from, mRows.begin() + from + 1);
+                }
+                mProxyRowsDirty = true;
+                endMoveRows();
+            }
+        }
+        previous = row;
+    }
+
+    // The rows are now a subsequence of the new results, insert the rest in between
+    for (std::size_t first = 0; first < rows.size();) {
+        if (first < mRows.size() && mRows[first] == rows[first]) {
+            ++first;
+            continue;
+        }
+        Q_ASSERT(!shown[rows[first]]);
+        auto last = first;
+        while (last + 1 < rows.size() && !shown[rows[last + 1]]) {
+            ++last;
+        }
+        beginInsertRows({}, static_cast<int>(first), static_cast<int>(last));
+        mRows.insert(mRows.begin() + first, rows.begin() + first, rows.begin() + last + 1);
+        mProxyRowsDirty = true;
+        endInsertRows();
+        first = last + 1;
+    }
+    Q_ASSERT(mRows == rows);
+}
+
+QVariant PasswordFilterModel::data(const QModelIndex &index, int role) const
+{
+    if (role == Qt::DisplayRole) {
+        return data(index, PasswordsModel::FullNameRole);
+    }
+    if (role == PasswordsModel::MatchRangesRole) {
+        // The ranges are relative to the full name, which is what this model displays
+        if (mFilter.filter.isEmpty() || mSortingLookupFilter != mFilter.filter) {
+            return {};
+        }
+        return QVariant::fromValue(mSortingLookup.ranges(mapToSource(index).row()));
+    }
+
+    return QAbstractProxyModel::data(index, role);
+}
+
+bool PasswordFilterModel::filterAcceptsRow(int sourceRow) const
+{
+    // The source lists only password entries, no folders
+    if (mFilter.filter.isEmpty()) {
+        const auto [first, last] = searchRange();
+        return sourceRow >= first && sourceRow < last;
+    }
+
+    // The lookup is normally ready by now, the worker thread may have calculated it
+    // while the updateTimer was ticking. It is missing when the rows change under an
+    // active filter, in that case it is calculated now.
+    ensureLookup();
+    return static_cast<std::size_t>(sourceRow) < mSortingLookup.weights.size() && mSortingLookup.weights[sourceRow] > -1;
+}
+
+bool PasswordFilterModel::lessThan(int sourceLeft, int sourceRight) const
+{
+    const auto weight = [this](int row) {
+        return static_cast<std::size_t>(row) < mSortingLookup.weights.size() ? mSortingLookup.weights[row] : -1;
+    };
+    const auto weightLeft = weight(sourceLeft);
+    const auto weightRight = weight(sourceRight);
 
     if (weightLeft == weightRight) {
-        const auto nameLeft = source_left.data(PasswordsModel::FullNameRole).toString();
-        const auto nameRight = source_right.data(PasswordsModel::FullNameRole).toString();
-        return QString::localeAwareCompare(nameLeft, nameRight) < 0;
+        const auto &left = mRowCache[sourceLeft];
+        const auto &right = mRowCache[sourceRight];
+        // Among equally good matches prefer the entries the user copies most often
+        if (left.usage != right.usage) {
+            return left.usage > right.usage;
+        }
+        return left.sortKey.compare(right.sortKey) < 0;
     }
 
     return weightLeft < weightRight;
@@ -5,19 +5,59 @@
 #ifndef PASSWORDFILTERMODEL_H_
 #define PASSWORDFILTERMODEL_H_
 
+#include "abbreviations.h"
+
+#include <QCache>
+#include <QCollator>
 #include <QFuture>
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
+#include <QPromise>
+#include <QRegularExpression>
 #include <QTimer>
 #include <QVector>
-class KDescendantsProxyModel;
+
+#include <chrono>
+#include <optional>
+#include <vector>
 
 namespace PlasmaPass
 {
-class PasswordFilterModel : public QSortFilterProxyModel
+class PasswordListModel;
+
+/**
+ * @brief Filtered and sorted flat list of all password entries.
+ *
+ * Unlike QSortFilterProxyModel, which re-sorts everything and emits a layout change
+ * whenever the filter changes, the model compares the new results with the previous
+ * ones and emits only the removals, moves and insertions between them, so views
+ * keep the delegates of entries that stay visible.
+ */
+class PasswordFilterModel : public QAbstractProxyModel
 {
     Q_OBJECT
 
+    /**
+     * Text to search for. A filter starting with "re:" is a case-insensitive regular
+     * expression and one starting with "glob:" a wildcard pattern, both are matched
+     * against the full names of the entries.
+     */
     Q_PROPERTY(QString passwordFilter READ passwordFilter WRITE setPasswordFilter NOTIFY passwordFilterChanged)
+    /**
+     * Whether to fall back to typo-tolerant matching when the query has too few regular matches.
+     * Enabled by default.
+     */
+    Q_PROPERTY(bool fuzzyMatching READ fuzzyMatching WRITE setFuzzyMatching NOTIFY fuzzyMatchingChanged)
+    /**
+     * Whether to search also in the non-secret fields (login, url, ...) of the entries.
+     * This requires decrypting every entry once to build the MetadataIndex, so it is
+     * disabled by default.
+     */
+    Q_PROPERTY(bool searchMetadata READ searchMetadata WRITE setSearchMetadata NOTIFY searchMetadataChanged)
+    /**
+     * Folder to search in, the whole store is searched when not set. The index may
+     * come from the source model or from any proxy model on top of it.
+     */
+    Q_PROPERTY(QModelIndex searchRoot READ searchRoot WRITE setSearchRoot RESET resetSearchRoot NOTIFY searchRootChanged)
 public:
     explicit PasswordFilterModel(QObject *parent = nullptr);
 
@@ -26,43 +66,179 @@ public:
     QString passwordFilter() const;
     void setPasswordFilter(const QString &filter);
 
+    bool fuzzyMatching() const;
+    void setFuzzyMatching(bool fuzzyMatching);
+
+    bool searchMetadata() const;
+    void setSearchMetadata(bool searchMetadata);
+
+    QModelIndex searchRoot() const;
+    void setSearchRoot(const QModelIndex &searchRoot);
+    void resetSearchRoot();
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = {}) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = {}) const override;
+    int columnCount(const QModelIndex &parent = {}) const override;
+    bool hasChildren(const QModelIndex &parent = {}) const override;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
     QVariant data(const QModelIndex &index, int role) const override;
 
 Q_SIGNALS:
     void passwordFilterChanged();
-
-protected:
-    bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const override;
-    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+    void fuzzyMatchingChanged();
+    void searchMetadataChanged();
+    void searchRootChanged();
 
 private:
-    struct PathFilter {
-        using result_type = std::pair<QModelIndex, int>;
+    bool lessThan(int sourceLeft, int sourceRight) const;
+    bool filterAcceptsRow(int sourceRow) const;
+    // Returns the accepted source rows in the order in which they are shown
+    std::vector<int> acceptedRows() const;
+    void updateRows();
+    void applyRows(std::vector<int> rows);
 
+    struct PathFilter {
         explicit PathFilter() = default;
-        PathFilter(QString filter);
+        PathFilter(QString filter,
+                   QStringList names = {},
+                   QList<QList<int>> positions = {},
+                   QList<QByteArray> latin1Names = {},
+                   QStringList foldedNames = {},
+                   QStringList foldedFields = {});
 
         PathFilter(const PathFilter &);
         PathFilter(PathFilter &&) noexcept;
         PathFilter &operator=(const PathFilter &);
         PathFilter &operator=(PathFilter &&) noexcept;
 
-        result_type operator()(const QModelIndex &index) const;
+        /**
+         * Returns the weight of the entry at given source row, -1 when it does not match.
+         * When @p ranges is given, it receives the matched characters of the full name.
+         */
+        int operator()(int row, MatchRanges *ranges = nullptr) const;
 
         QString filter;
+        // Full names with diacritics removed (see normalizeForMatching()) indexed by source row
+        QStringList names;
+        // Positions of the characters of the names in the full names, for mapping the
+        // matched ranges back. Empty for names that are the same as their full name.
+        QList<QList<int>> positions;
+        // Latin-1 copies of the names indexed by source row, null for names that
+        // contain other characters. Used for the faster 8-bit matching.
+        QList<QByteArray> latin1Names;
+        // Case-folded names indexed by source row, used for typo-tolerant
+        // matching. When empty, only the regular matching is done.
+        QStringList foldedNames;
+        // Case-folded MetadataIndex fields indexed by source row. When empty, the
+        // fields are not searched.
+        QStringList foldedFields;
 
     private:
         void updateParts();
+        // Set for the "re:" and "glob:" filters, which are matched with mRegex only
+        bool mPatternMatching = false;
+        QRegularExpression mRegex;
+        // Filter mRegex has been compiled for, copies of the filter share it
+        QString mRegexFilter;
         QVector<QStringView> mParts;
+        QByteArray mLatin1Filter;
+        QVector<QLatin1StringView> mLatin1Parts;
+        QString mFoldedFilter;
+        FuzzyMatcher mFuzzyMatcher;
     };
 
     void delayedUpdateFilter();
+    // Result of matching the rows against a filter
+    struct Lookup {
+        /**
+         * Returns the matched ranges of given row as a flat list of start and length pairs.
+         */
+        QList<int> ranges(int row) const;
+
+        // Weights indexed by source row, -1 for rows that do not match
+        std::vector<int> weights;
+        // The matched rows start at firstRow and are matched in chunks of DefaultChunkSize
+        // rows. Each chunk stores the MatchRanges of its rows in its own buffer, so the
+        // chunks can be matched independently and nothing needs to be merged.
+        int firstRow = 0;
+        std::vector<std::vector<quint32>> chunkRanges;
+        // End of the ranges of each row in the buffer of its chunk, indexed by row - firstRow
+        std::vector<quint32> rangeEnds;
+    };
 
-    KDescendantsProxyModel *mFlatModel = nullptr;
+    static Lookup computeLookup(const PathFilter &filter, std::pair<int, int> range, QPromise<Lookup> *promise = nullptr);
+    void setLookup(const QString &filter, Lookup lookup) const;
+    bool restoreLookup(const QString &filter);
+    void checkLookupCacheGeneration() const;
+    std::pair<int, int> searchRange() const;
+    void ensureLookup() const;
+    void applyFuzzyTier(std::vector<int> &lookup) const;
+    void invalidateRowCache();
+    void ensureRowCache() const;
+    PathFilter createPathFilter(const QString &filter) const;
+    void rerunFilter();
+
+    // Per-entry data used for sorting, computed once per tree
+    struct CachedRow {
+        QCollatorSortKey sortKey;
+        double usage; // frecency score from UsageStore
+    };
+
+    PasswordListModel *mFlatModel = nullptr;
+    // Source rows in the order in which they are shown
+    std::vector<int> mRows;
+    // Position of each source row in mRows, -1 for rows that are not shown. Rebuilt
+    // only when mapFromSource() needs it.
+    mutable std::vector<int> mProxyRows;
+    mutable bool mProxyRowsDirty = true;
+    QCollator mCollator;
+    // Indexed by the source row
+    mutable std::vector<CachedRow> mRowCache;
+    mutable bool mRowCacheDirty = true;
+    mutable bool mUsageDirty = true;
+    mutable QStringList mFullNames;
+    mutable QStringList mNames;
+    mutable QList<QList<int>> mPositions;
+    mutable QStringList mFoldedNames;
+    mutable QList<QByteArray> mLatin1Names;
+    mutable QStringList mFoldedFields;
+    mutable bool mFieldsDirty = true;
     PathFilter mFilter;
-    mutable QHash<QModelIndex, int> mSortingLookup;
+    bool mFuzzyMatching = true;
+    bool mSearchMetadata = false;
+    // Index in the PasswordsModel
+    QPersistentModelIndex mSearchRoot;
+    // Whether the typo-tolerant matches are accepted for the current filter
+    mutable bool mFuzzyTierActive = false;
+    // Results for mSortingLookupFilter
+    mutable Lookup mSortingLookup;
+    mutable QString mSortingLookupFilter;
     QTimer mUpdateTimer;
-    QFuture<QHash<QModelIndex, int>> mFuture;
+    QFuture<Lookup> mFuture;
+    // Set when mSortingLookup has been calculated by the worker
+    bool mLookupFromWorker = false;
+
+    struct CachedLookup {
+        Lookup lookup;
+        bool fuzzyTierActive = false;
+    };
+    // Results of recent filters, keyed by the case-folded filter (patterns are kept as
+    // they are, their case matters). The cost of each entry is its size in bytes.
+    // Cleared whenever the results could change: when the store is reloaded (see
+    // PasswordsModel::generation()) or the settings change.
+    mutable QCache<QString, CachedLookup> mLookupCache;
+    mutable quint64 mLookupCacheGeneration = 0;
+    // Set when the filter is applied only once the worker finishes
+    bool mWaitingForWorker = false;
+
+    // Measured costs of filtering, they decide how the next filter is applied.
+    // The synchronous cost is that of matching all rows and invalidating on the GUI thread.
+    std::optional<std::chrono::microseconds> mSyncCost;
+    std::optional<std::chrono::microseconds> mWorkerCost;
+    std::chrono::microseconds mLastWorkerCost{0};
 };
 
 }
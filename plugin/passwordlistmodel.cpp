@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "passwordlistmodel.h"
+#include "passwordsmodel.h"
+
+using namespace PlasmaPass;
+
+PasswordListModel::PasswordListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+PasswordsModel *PasswordListModel::passwordsModel() const
+{
+    return mModel;
+}
+
+void PasswordListModel::setPasswordsModel(PasswordsModel *model)
+{
+    if (mModel == model) {
+        return;
+    }
+
+    beginResetModel();
+    if (mModel) {
+        disconnect(mModel, nullptr, this, nullptr);
+    }
+    mModel = model;
+    if (mModel) {
+        // The entry list is only ever rebuilt as a whole
+        connect(mModel, &QAbstractItemModel::modelAboutToBeReset, this, &PasswordListModel::beginResetModel);
+        connect(mModel, &QAbstractItemModel::modelReset, this, &PasswordListModel::endResetModel);
+        connect(mModel, &QObject::destroyed, this, [this]() {
+            beginResetModel();
+            endResetModel();
+        });
+    }
+    endResetModel();
+}
+
+QHash<int, QByteArray> PasswordListModel::roleNames() const
+{
+    return mModel ? mModel->roleNames() : QAbstractListModel::roleNames();
+}
+
+int PasswordListModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !mModel) {
+        return 0;
+    }
+    return mModel->entryCount();
+}
+
+QVariant PasswordListModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, CheckIndexOption::IndexIsValid | CheckIndexOption::ParentIsInvalid) || !mModel) {
+        return {};
+    }
+    return mModel->entryData(index.row(), role);
+}
+
+QString PasswordListModel::fullName(int row) const
+{
+    return mModel ? mModel->entryFullName(row) : QString();
+}
+
+QModelIndex PasswordListModel::mapToPasswordsModel(const QModelIndex &index) const
+{
+    if (!index.isValid() || !mModel) {
+        return {};
+    }
+    return mModel->entryIndex(index.row());
+}
+
+#include "moc_passwordlistmodel.cpp"
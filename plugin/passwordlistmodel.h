@@ -0,0 +1,50 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef PASSWORDLISTMODEL_H_
+#define PASSWORDLISTMODEL_H_
+
+#include <QAbstractListModel>
+#include <QPointer>
+
+namespace PlasmaPass
+{
+class PasswordsModel;
+
+/**
+ * @brief Flat list of all password entries of a PasswordsModel.
+ *
+ * The rows come straight from the entry list of the PasswordsModel, so unlike
+ * flattening the tree through a proxy there are no mapping tables to build and
+ * every data() call is a direct lookup. Folders are not listed. The roles are
+ * the same as those of PasswordsModel.
+ */
+class PasswordListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    explicit PasswordListModel(QObject *parent = nullptr);
+
+    PasswordsModel *passwordsModel() const;
+    void setPasswordsModel(PasswordsModel *model);
+
+    QHash<int, QByteArray> roleNames() const override;
+
+    int rowCount(const QModelIndex &parent = {}) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+    QString fullName(int row) const;
+
+    /**
+     * @brief Returns index of the entry in the PasswordsModel.
+     */
+    QModelIndex mapToPasswordsModel(const QModelIndex &index) const;
+
+private:
+    QPointer<PasswordsModel> mModel;
+};
+
+}
+
+#endif // PASSWORDLISTMODEL_H_
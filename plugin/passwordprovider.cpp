@@ -8,7 +8,7 @@ using namespace PlasmaPass;
 
 ProviderBase::HandlingResult PasswordProvider::handleSecret(QStringView secret)
 {
-    setSecret(secret.toString());
+    setSecret(SecretBuffer(secret));
     // We are only interested in the first line for passwords
     return HandlingResult::Stop;
 }
@@ -5,14 +5,32 @@
 #include "passwordsmodel.h"
 #include "passwordprovider.h"
 #include "otpprovider.h"
+#include "usagestore.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QPointer>
 
+#include <algorithm>
+#include <optional>
+
 using namespace PlasmaPass;
 
 static constexpr const char *passwordStoreDir = "PASSWORD_STORE_DIR";
 
+namespace
+{
+// Records a usage of the entry once the provider has put the secret into the clipboard
+void trackUsage(ProviderBase *provider, const QString &fullName)
+{
+    QObject::connect(provider, &ProviderBase::validChanged, provider, [provider, fullName]() {
+        if (provider->isValid()) {
+            UsageStore::instance()->recordUsage(fullName);
+        }
+    });
+}
+} // namespace
+
 struct PasswordsModel::Node {
     explicit Node() = default;
     Node(QString name, PasswordsModel::EntryType type, Node *nodeParent)
@@ -21,6 +39,7 @@ struct PasswordsModel::Node {
         , parent(nodeParent)
     {
         if (parent != nullptr) {
+            row = static_cast<int>(parent->children.size());
             parent->children.push_back(std::unique_ptr<Node>(this));
         }
     }
@@ -63,26 +82,36 @@ struct PasswordsModel::Node {
         return mFullName;
     }
 
+    const QCollatorSortKey &sortKey(const QCollator &collator) const
+    {
+        if (!mSortKey.has_value()) {
+            mSortKey = collator.sortKey(name);
+        }
+        return *mSortKey;
+    }
+
     QString name;
     PasswordsModel::EntryType type = PasswordsModel::FolderEntry;
     QPointer<PasswordProvider> provider;
     QPointer<OTPProvider> otpProvider;
     Node *parent = nullptr;
+    int row = 0; // position within the parent
+    // Range of the entries in PasswordsModel::mEntries in this subtree
+    int firstEntry = 0;
+    int lastEntry = 0;
     std::vector<std::unique_ptr<Node>> children;
 
 private:
     mutable QString mFullName;
+    mutable std::optional<QCollatorSortKey> mSortKey;
 };
 
 PasswordsModel::PasswordsModel(QObject *parent)
     : QAbstractItemModel(parent)
     , mWatcher(this)
+    , mPassStore(passwordStore())
 {
-    if (qEnvironmentVariableIsSet(passwordStoreDir)) {
-        mPassStore = QDir(QString::fromUtf8(qgetenv(passwordStoreDir)));
-    } else {
-        mPassStore = QDir(QStringLiteral("%1/.password-store").arg(QDir::homePath()));
-    }
+    mCollator.setCaseSensitivity(Qt::CaseInsensitive);
 
     // FIXME: Try to figure out what has actually changed and update the model
     // accordingly instead of reseting it
@@ -93,6 +122,33 @@ PasswordsModel::PasswordsModel(QObject *parent)
 
 PasswordsModel::~PasswordsModel() = default;
 
+QDir PasswordsModel::passwordStore()
+{
+    if (qEnvironmentVariableIsSet(passwordStoreDir)) {
+        return QDir(QString::fromUtf8(qgetenv(passwordStoreDir)));
+    }
+    return QDir(QStringLiteral("%1/.password-store").arg(QDir::homePath()));
+}
+
+QStringList PasswordsModel::passwordStoreKeyIds()
+{
+    QFile gpgId(passwordStore().absoluteFilePath(QStringLiteral(".gpg-id")));
+    if (!gpgId.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Failed to read" << gpgId.fileName() << ":" << gpgId.errorString();
+        return {};
+    }
+
+    QStringList keyIds;
+    const auto lines = QString::fromUtf8(gpgId.readAll()).split(QLatin1Char('\n'));
+    for (const auto &line : lines) {
+        const auto keyId = line.trimmed();
+        if (!keyId.isEmpty() && !keyId.startsWith(QLatin1Char('#'))) {
+            keyIds.push_back(keyId);
+        }
+    }
+    return keyIds;
+}
+
 PasswordsModel::Node *PasswordsModel::node(const QModelIndex &index)
 {
     return static_cast<Node *>(index.internalPointer());
@@ -107,8 +163,8 @@ QHash<int, QByteArray> PasswordsModel::roleNames() const
             {HasPasswordRole, "hasPassword"},
             {PasswordRole, "password"},
             {OTPRole, "otp"},
-            {HasOTPRole, "hasOtp"}};
-
+            {HasOTPRole, "hasOtp"},
+            {MatchRangesRole, "matchRanges"}};
 }
 
 int PasswordsModel::rowCount(const QModelIndex &parent) const
@@ -148,12 +204,7 @@ QModelIndex PasswordsModel::parent(const QModelIndex &child) const
         return {};
     }
 
-    auto &children = parentNode->parent->children;
-    const auto it = std::find_if(children.cbegin(), children.cend(), [parentNode](const auto &node) {
-        return node.get() == parentNode;
-    });
-    Q_ASSERT(it != children.cend());
-    return createIndex(std::distance(children.cbegin(), it), 0, parentNode);
+    return createIndex(parentNode->row, 0, parentNode);
 }
 
 QVariant PasswordsModel::data(const QModelIndex &index, int role) const
@@ -161,7 +212,11 @@ QVariant PasswordsModel::data(const QModelIndex &index, int role) const
     if (!index.isValid()) {
         return {};
     }
-    const auto node = this->node(index);
+    return nodeData(node(index), role);
+}
+
+QVariant PasswordsModel::nodeData(Node *node, int role) const
+{
     if (node == nullptr) {
         return {};
     }
@@ -178,11 +233,13 @@ QVariant PasswordsModel::data(const QModelIndex &index, int role) const
     case PasswordRole:
         if (node->provider == nullptr) {
             node->provider = new PasswordProvider(node->path());
+            trackUsage(node->provider, node->fullName());
         }
         return QVariant::fromValue(node->provider.data());
     case OTPRole:
         if (node->otpProvider == nullptr) {
-            node->otpProvider = new OTPProvider(node->path());
+            node->otpProvider = new OTPProvider(node->path(), mOtpSession);
+            trackUsage(node->otpProvider, node->fullName());
         }
         return QVariant::fromValue(node->otpProvider.data());
     case HasPasswordRole:
@@ -194,9 +251,84 @@ QVariant PasswordsModel::data(const QModelIndex &index, int role) const
     }
 }
 
+bool PasswordsModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    const auto leftNode = node(left);
+    const auto rightNode = node(right);
+    Q_ASSERT(leftNode != nullptr && rightNode != nullptr);
+
+    // Folders first
+    if (leftNode->type != rightNode->type) {
+        return leftNode->type == FolderEntry;
+    }
+
+    return leftNode->sortKey(mCollator).compare(rightNode->sortKey(mCollator)) < 0;
+}
+
+int PasswordsModel::entryCount() const
+{
+    return static_cast<int>(mEntries.size());
+}
+
+QModelIndex PasswordsModel::entryIndex(int entry) const
+{
+    if (entry < 0 || entry >= entryCount()) {
+        return {};
+    }
+
+    const auto node = mEntries[entry];
+    return createIndex(node->row, 0, node);
+}
+
+QString PasswordsModel::entryFullName(int entry) const
+{
+    if (entry < 0 || entry >= entryCount()) {
+        return {};
+    }
+    return mEntries[entry]->fullName();
+}
+
+QVariant PasswordsModel::entryData(int entry, int role) const
+{
+    if (entry < 0 || entry >= entryCount()) {
+        return {};
+    }
+    return nodeData(mEntries[entry], role);
+}
+
+std::pair<int, int> PasswordsModel::entryRange(const QModelIndex &index) const
+{
+    const auto node = index.isValid() ? this->node(index) : mRoot.get();
+    if (node == nullptr) {
+        return {0, 0};
+    }
+    return {node->firstEntry, node->lastEntry};
+}
+
+quint64 PasswordsModel::generation() const
+{
+    return mGeneration;
+}
+
+int PasswordsModel::otpSession() const
+{
+    return static_cast<int>(mOtpSession.count());
+}
+
+void PasswordsModel::setOtpSession(int seconds)
+{
+    const std::chrono::seconds session(std::max(seconds, 0));
+    if (mOtpSession != session) {
+        mOtpSession = session;
+        Q_EMIT otpSessionChanged();
+    }
+}
+
 void PasswordsModel::populate()
 {
+    ++mGeneration;
     beginResetModel();
+    mEntries.clear();
     mRoot = std::make_unique<Node>();
     mRoot->name = mPassStore.absolutePath();
     populateDir(mPassStore, mRoot.get());
@@ -206,15 +338,20 @@ void PasswordsModel::populate()
 void PasswordsModel::populateDir(const QDir &dir, Node *parent)
 {
     mWatcher.addPath(dir.absolutePath());
+    parent->firstEntry = static_cast<int>(mEntries.size());
     auto entries = dir.entryInfoList({QStringLiteral("*.gpg")}, QDir::Files, QDir::NoSort);
     for (const auto &entry : qAsConst(entries)) {
-        new Node(entry.completeBaseName(), PasswordEntry, parent);
+        auto node = new Node(entry.completeBaseName(), PasswordEntry, parent);
+        node->firstEntry = static_cast<int>(mEntries.size());
+        node->lastEntry = node->firstEntry + 1;
+        mEntries.push_back(node);
     }
     entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::NoSort);
     for (const auto &entry : qAsConst(entries)) {
         auto node = new Node(entry.fileName(), FolderEntry, parent);
         populateDir(entry.absoluteFilePath(), node);
     }
+    parent->lastEntry = static_cast<int>(mEntries.size());
 }
 
 #include "moc_passwordsmodel.cpp"
@@ -6,10 +6,13 @@
 #define PASSWORDSMODEL_H_
 
 #include <QAbstractItemModel>
+#include <QCollator>
 #include <QDir>
 #include <QFileSystemWatcher>
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 namespace PlasmaPass
 {
@@ -17,6 +20,13 @@ class PasswordsModel : public QAbstractItemModel
 {
     Q_OBJECT
 
+    /**
+     * For how many seconds an OTP keeps the decoded key and refreshes its code at every
+     * step, without decrypting the entry again. 0, the default, generates a single code.
+     * Applies to OTPs requested after the change.
+     */
+    Q_PROPERTY(int otpSession READ otpSession WRITE setOtpSession NOTIFY otpSessionChanged)
+
     struct Node;
 
 public:
@@ -34,12 +44,29 @@ public:
         PasswordRole,
         OTPRole,
         HasPasswordRole,
-        HasOTPRole
+        HasOTPRole,
+        /**
+         * Characters of the displayed text that matched the current filter, as a flat
+         * list of start and length pairs. Only provided by PasswordFilterModel.
+         */
+        MatchRangesRole,
     };
 
     explicit PasswordsModel(QObject *parent = nullptr);
     ~PasswordsModel() override;
 
+    /**
+     * Returns the root directory of the password store, either from the PASSWORD_STORE_DIR
+     * environment variable or the default ~/.password-store.
+     */
+    static QDir passwordStore();
+
+    /**
+     * Returns the IDs of the keys the password store is encrypted to, as listed in the
+     * .gpg-id file in its root. Empty when the file cannot be read.
+     */
+    static QStringList passwordStoreKeyIds();
+
     QHash<int, QByteArray> roleNames() const override;
 
     int rowCount(const QModelIndex &parent) const override;
@@ -50,16 +77,60 @@ public:
 
     QVariant data(const QModelIndex &index, int role) const override;
 
+    /**
+     * Compares two entries of this model: folders go first, the rest is ordered
+     * by a locale-aware, case-insensitive collation key of the entry name.
+     *
+     * The keys are computed once per entry and are dropped together with the tree,
+     * so comparing two entries does not go through data() nor re-collates the names.
+     */
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+
+    /**
+     * Password entries of the whole tree in a flat list, in the order in which they
+     * appear in the tree. Folders are not included. The list is rebuilt on model reset.
+     */
+    int entryCount() const;
+    QModelIndex entryIndex(int entry) const;
+    QString entryFullName(int entry) const;
+    QVariant entryData(int entry, int role) const;
+
+    /**
+     * Returns the [first, last) range of the entries within the folder at @p index.
+     *
+     * The entry list is in pre-order, so all entries below a folder are next to each
+     * other. For a password entry the range contains just that entry, for an invalid
+     * index it is the whole list.
+     */
+    std::pair<int, int> entryRange(const QModelIndex &index) const;
+
+    /**
+     * Returns a number that changes every time the store is reloaded, so results
+     * computed from the entries can tell whether they are still valid.
+     */
+    quint64 generation() const;
+
+    int otpSession() const;
+    void setOtpSession(int seconds);
+
+Q_SIGNALS:
+    void otpSessionChanged();
+
 private:
     void populate();
     void populateDir(const QDir &dir, Node *parent);
+    QVariant nodeData(Node *node, int role) const;
 
     static Node *node(const QModelIndex &index);
 
     QFileSystemWatcher mWatcher;
     QDir mPassStore;
+    QCollator mCollator;
 
     std::unique_ptr<Node> mRoot;
+    std::vector<Node *> mEntries;
+    quint64 mGeneration = 0;
+    std::chrono::seconds mOtpSession{0};
 };
 
 }
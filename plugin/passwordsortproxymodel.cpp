@@ -15,8 +15,20 @@ PasswordSortProxyModel::PasswordSortProxyModel(QObject *parent)
     sort(0); // enable sorting
 }
 
+void PasswordSortProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    mPasswordsModel = qobject_cast<PasswordsModel *>(sourceModel);
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+}
+
 bool PasswordSortProxyModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
 {
+    // PasswordsModel keeps a precomputed collation key for each entry, use it when it matches
+    // how we are configured to sort instead of collating the names on every comparison.
+    if (mPasswordsModel != nullptr && sortRole() == Qt::DisplayRole && isSortLocaleAware() && sortCaseSensitivity() == Qt::CaseInsensitive) {
+        return mPasswordsModel->lessThan(source_left, source_right);
+    }
+
     const auto typeLeft = static_cast<PasswordsModel::EntryType>(source_left.data(PasswordsModel::EntryTypeRole).toInt());
     const auto typeRight = static_cast<PasswordsModel::EntryType>(source_right.data(PasswordsModel::EntryTypeRole).toInt());
 
@@ -9,14 +9,21 @@
 
 namespace PlasmaPass
 {
+class PasswordsModel;
+
 class PasswordSortProxyModel : public QSortFilterProxyModel
 {
     Q_OBJECT
 public:
     explicit PasswordSortProxyModel(QObject *parent = nullptr);
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
 protected:
     bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const override;
+
+private:
+    PasswordsModel *mPasswordsModel = nullptr;
 };
 
 }
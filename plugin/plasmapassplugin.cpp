@@ -3,6 +3,9 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "plasmapassplugin.h"
+#include "decryptionservice.h"
+#include "otpdashboard.h"
+#include "passwordaudit.h"
 #include "passwordfiltermodel.h"
 #include "passwordprovider.h"
 #include "otpprovider.h"
@@ -20,9 +23,12 @@ void PlasmaPassPlugin::registerTypes(const char *uri)
     qmlRegisterType<PlasmaPass::PasswordsModel>(uri, 1, 0, "PasswordsModel");
     qmlRegisterType<PlasmaPass::PasswordSortProxyModel>(uri, 1, 0, "PasswordSortProxyModel");
     qmlRegisterType<PlasmaPass::PasswordFilterModel>(uri, 1, 0, "PasswordFilterModel");
+    qmlRegisterType<PlasmaPass::PasswordAudit>(uri, 1, 0, "PasswordAudit");
+    qmlRegisterType<PlasmaPass::OTPDashboard>(uri, 1, 0, "OTPDashboard");
     qmlRegisterUncreatableType<PlasmaPass::ProviderBase>(uri, 1, 0, "ProviderBase", QString());
     qmlRegisterUncreatableType<PlasmaPass::PasswordProvider>(uri, 1, 0, "PasswordProvider", QString());
     qmlRegisterUncreatableType<PlasmaPass::OTPProvider>(uri, 1, 0, "OTPProvider", QString());
+    qmlRegisterSingletonInstance(uri, 1, 0, "DecryptionService", PlasmaPass::DecryptionService::instance());
 
     qmlProtectModule("org.kde.plasma.private.plasmapass", 1);
 }
@@ -3,15 +3,19 @@
 // SPDX-License-Identifier: LGPL-2.1-or-later
 
 #include "providerbase.h"
+#include "deadlinescheduler.h"
+#include "decryptionservice.h"
 #include "klipperinterface.h"
 #include "plasmapass_debug.h"
 
 #include <QClipboard>
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QGuiApplication>
 #include <QMimeData>
 #include <QProcess>
 #include <QStandardPaths>
+#include <QTimer>
 
 #include <QDBusConnection>
 
@@ -26,10 +30,6 @@
 #include <chrono>
 #include <utility>
 
-#include <QGpgME/DecryptJob>
-#include <QGpgME/Protocol>
-#include <gpgme++/decryptionresult.h>
-
 using namespace std::chrono;
 using namespace std::chrono_literals;
 using namespace PlasmaPass;
@@ -37,7 +37,6 @@ using namespace PlasmaPass;
 namespace
 {
 constexpr const auto DefaultSecretTimeout = 45s;
-constexpr const auto SecretTimeoutUpdateInterval = 100ms;
 
 const QString klipperDBusService = QStringLiteral("org.kde.klipper");
 const QString klipperDBusPath = QStringLiteral("/klipper");
@@ -52,58 +51,37 @@ ProviderBase::ProviderBase(const QString &path, QObject *parent)
     , mPath(path)
     , mSecretTimeout(DefaultSecretTimeout)
 {
-    mTimer.setInterval(SecretTimeoutUpdateInterval);
-    connect(&mTimer, &QTimer::timeout, this, [this]() {
-        mTimeout -= mTimer.interval();
-        Q_EMIT timeoutChanged();
-        if (mTimeout == 0) {
-            expireSecret();
-        }
-    });
-
     QTimer::singleShot(0, this, &ProviderBase::start);
 }
 
-ProviderBase::~ProviderBase() = default;
+ProviderBase::~ProviderBase()
+{
+    // Don't keep decrypting (or waiting to decrypt) an entry nobody wants anymore
+    DecryptionService::instance()->cancel(this);
+    DeadlineScheduler::instance()->cancel(mExpiryId);
+}
 
 void ProviderBase::start()
 {
-    QFile file(mPath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qCWarning(PLASMAPASS_LOG, "Failed to open password file: %s", qUtf8Printable(file.errorString()));
-        setError(i18n("Failed to open password file: %1", file.errorString()));
-        return;
-    }
-
-    auto decryptJob = QGpgME::openpgp()->decryptJob();
-    connect(decryptJob, &QGpgME::DecryptJob::result, this, [this](const GpgME::DecryptionResult &result, const QByteArray &plainText) {
-        if (result.error()) {
-            qCWarning(PLASMAPASS_LOG, "Failed to decrypt password: %s", result.error().asString());
-            setError(i18n("Failed to decrypt password: %1", QString::fromUtf8(result.error().asString())));
-            return;
-        }
-
-        const auto data = QString::fromUtf8(plainText);
-        if (data.isEmpty()) {
-            qCWarning(PLASMAPASS_LOG, "Password file is empty!");
-            setError(i18n("No password found"));
-            return;
-        }
-
-        const auto lines = QStringView(data).split(QLatin1Char('\n'));
-        for (const auto &line : lines) {
-            if (handleSecret(line) == HandlingResult::Stop) {
-                break;
+    mDecryptionTimer.start();
+    // Other providers of the same entry get it without decrypting it again for as long as we hold it
+    mEntry = DecryptionService::instance()->decrypt(
+        mPath,
+        this,
+        [this](QStringView line) {
+            return handleSecret(line) == HandlingResult::Stop;
+        },
+        [this](const QString &error) {
+            // The decryption may fail at its very end, when the secret has been handed out already
+            if (isValid()) {
+                removePasswordFromClipboard(mSecret.view());
+                mSecret.clear();
+                stopExpiry();
+                Q_EMIT validChanged();
+                Q_EMIT secretChanged();
             }
-        }
-    });
-
-    const auto error = decryptJob->start(file.readAll());
-    if (error) {
-        qCWarning(PLASMAPASS_LOG, "Failed to decrypt password: %s", error.asString());
-        setError(i18n("Failed to decrypt password: %1", QString::fromUtf8(error.asString())));
-        return;
-    }
+            setError(error);
+        });
 }
 
 bool ProviderBase::isValid() const
@@ -113,15 +91,17 @@ bool ProviderBase::isValid() const
 
 QString ProviderBase::secret() const
 {
-    return mSecret;
+    // Only for QML, which cannot do without a copy
+    return mSecret.toString();
 }
 
 namespace {
 
-QMimeData *mimeDataForPassword(const QString &password)
+QMimeData *mimeDataForPassword(QStringView password)
 {
     auto mimeData = new QMimeData;
-    mimeData->setText(password);
+    // The clipboard is where the secret has to leave the locked memory
+    mimeData->setText(password.toString());
     // https://phabricator.kde.org/D12539
     mimeData->setData(QStringLiteral("x-kde-passwordManagerHint"), "secret");
     return mimeData;
@@ -129,22 +109,45 @@ QMimeData *mimeDataForPassword(const QString &password)
 
 } // namespace
 
-void ProviderBase::setSecret(const QString &secret)
+void ProviderBase::setSecret(SecretBuffer secret)
 {
     auto clipboard = qGuiApp->clipboard(); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
-    clipboard->setMimeData(mimeDataForPassword(secret), QClipboard::Clipboard);
+    clipboard->setMimeData(mimeDataForPassword(secret.view()), QClipboard::Clipboard);
 
     if (clipboard->supportsSelection()) {
-        clipboard->setMimeData(mimeDataForPassword(secret), QClipboard::Selection);
+        clipboard->setMimeData(mimeDataForPassword(secret.view()), QClipboard::Selection);
     }
 
-    mSecret = secret;
+    qCDebug(PLASMAPASS_LOG, "Secret copied to clipboard %lld ms after the decryption started", mDecryptionTimer.elapsed());
+
+    mSecret = std::move(secret);
     Q_EMIT validChanged();
     Q_EMIT secretChanged();
 
-    mTimeout = defaultTimeout();
+    DeadlineScheduler::instance()->cancel(mExpiryId);
+    mExpiry = QDeadlineTimer(mSecretTimeout, Qt::PreciseTimer);
+    mExpiresAt = QDateTime::currentMSecsSinceEpoch() + defaultTimeout();
+    mExpiryId = DeadlineScheduler::instance()->schedule(mExpiry, this, [this]() {
+        mExpiryId = 0;
+        expireSecret();
+    });
     Q_EMIT timeoutChanged();
-    mTimer.start();
+}
+
+void ProviderBase::replaceSecret(SecretBuffer secret)
+{
+    // Don't overwrite whatever the user has copied since. The old secret may stay in the
+    // history of an old Klipper, but it is of no use once it has been replaced.
+    auto clipboard = qGuiApp->clipboard(); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+    if (clipboard->text(QClipboard::Clipboard) == mSecret.view()) {
+        clipboard->setMimeData(mimeDataForPassword(secret.view()), QClipboard::Clipboard);
+    }
+    if (clipboard->supportsSelection() && clipboard->text(QClipboard::Selection) == mSecret.view()) {
+        clipboard->setMimeData(mimeDataForPassword(secret.view()), QClipboard::Selection);
+    }
+
+    mSecret = std::move(secret);
+    Q_EMIT secretChanged();
 }
 
 void ProviderBase::setSecretTimeout(std::chrono::seconds timeout)
@@ -154,10 +157,12 @@ void ProviderBase::setSecretTimeout(std::chrono::seconds timeout)
 
 void ProviderBase::expireSecret()
 {
-    removePasswordFromClipboard(mSecret);
+    removePasswordFromClipboard(mSecret.view());
 
+    // Wipes the secret right away, the entry is wiped once no other provider holds it
+    mEntry.reset();
     mSecret.clear();
-    mTimer.stop();
+    stopExpiry();
     Q_EMIT validChanged();
     Q_EMIT secretChanged();
 
@@ -165,9 +170,21 @@ void ProviderBase::expireSecret()
     deleteLater();
 }
 
+void ProviderBase::stopExpiry()
+{
+    DeadlineScheduler::instance()->cancel(std::exchange(mExpiryId, 0));
+    mExpiresAt = 0;
+    Q_EMIT timeoutChanged();
+}
+
 int ProviderBase::timeout() const
 {
-    return mTimeout;
+    return mExpiresAt == 0 ? 0 : static_cast<int>(mExpiry.remainingTime());
+}
+
+qint64 ProviderBase::expiresAt() const
+{
+    return mExpiresAt;
 }
 
 int ProviderBase::defaultTimeout() const
@@ -194,8 +211,9 @@ void ProviderBase::setError(const QString &error)
 void ProviderBase::reset()
 {
     mError.clear();
+    mEntry.reset();
     mSecret.clear();
-    mTimer.stop();
+    stopExpiry();
     Q_EMIT errorChanged();
     Q_EMIT validChanged();
     Q_EMIT secretChanged();
@@ -203,7 +221,7 @@ void ProviderBase::reset()
     QTimer::singleShot(0, this, &ProviderBase::start);
 }
 
-void ProviderBase::removePasswordFromClipboard(const QString &password)
+void ProviderBase::removePasswordFromClipboard(QStringView password)
 {
     // Clear the WS clipboard itself
     const auto clipboard = qGuiApp->clipboard(); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
@@ -244,7 +262,9 @@ void ProviderBase::removePasswordFromClipboard(const QString &password)
     // (see klipper/historystringitem.cpp) so we try here to obtain a service directly
     // for the history item with our password so that we can only remove the
     // password from the history without having to clear the entire history.
-    const auto service = engine->serviceForSource(QString::fromLatin1(QCryptographicHash::hash(password.toUtf8(), QCryptographicHash::Sha1).toBase64()));
+    auto utf8Password = password.toUtf8();
+    const auto service = engine->serviceForSource(QString::fromLatin1(QCryptographicHash::hash(utf8Password, QCryptographicHash::Sha1).toBase64()));
+    utf8Password.fill('\0');
     if (service == nullptr) {
         qCWarning(PLASMAPASS_LOG, "Failed to obtain PlasmaService for the password, falling back to clearClipboard()");
         mEngineConsumer.reset();
@@ -5,10 +5,12 @@
 #ifndef PROVIDERBASE_H_
 #define PROVIDERBASE_H_
 
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
 #include <QObject>
-#include <QTimer>
 
 #include "klipperutils.h"
+#include "secretbuffer.h"
 
 #include <memory>
 
@@ -24,13 +26,23 @@ class DataEngineConsumer;
 namespace PlasmaPass
 {
 class PasswordsModel;
+struct DecryptedEntry;
 
 class ProviderBase : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY(bool valid READ isValid NOTIFY validChanged)
+    /**
+     * Milliseconds left until the secret expires. Computed when read, timeoutChanged()
+     * is emitted only when the secret is set or removed, not as the time goes.
+     */
     Q_PROPERTY(int timeout READ timeout NOTIFY timeoutChanged)
+    /**
+     * When the secret expires, in milliseconds since the epoch, 0 when there is no secret.
+     * Views animate the countdown to it themselves.
+     */
+    Q_PROPERTY(qint64 expiresAt READ expiresAt NOTIFY timeoutChanged)
     Q_PROPERTY(int defaultTimeout READ defaultTimeout CONSTANT)
     Q_PROPERTY(QString secret READ secret NOTIFY secretChanged)
     Q_PROPERTY(bool hasError READ hasError NOTIFY errorChanged)
@@ -43,6 +55,7 @@ public:
     QString secret() const;
     bool isValid() const;
     int timeout() const;
+    qint64 expiresAt() const;
     int defaultTimeout() const; // in milliseconds
     bool hasError() const;
     QString error() const;
@@ -59,9 +72,15 @@ Q_SIGNALS:
 protected:
     explicit ProviderBase(const QString &path, QObject *parent = nullptr);
 
-    void setSecret(const QString &secret);
+    void setSecret(SecretBuffer secret);
+    /**
+     * Swaps the secret for a new one without restarting the expiry. The clipboard is
+     * updated only while it still holds the old secret.
+     */
+    void replaceSecret(SecretBuffer secret);
     void setSecretTimeout(std::chrono::seconds timeout);
     void setError(const QString &error);
+    void expireSecret();
 
     enum class HandlingResult {
         Continue,
@@ -74,16 +93,19 @@ private Q_SLOTS:
     void onPlasmaServiceRemovePasswordResult(KJob *job);
 
 private:
-    void expireSecret();
+    void stopExpiry();
 
-    void removePasswordFromClipboard(const QString &password);
+    void removePasswordFromClipboard(QStringView password);
     static void clearClipboard();
     std::unique_ptr<Plasma5Support::DataEngineConsumer> mEngineConsumer;
     QString mPath;
+    std::shared_ptr<const DecryptedEntry> mEntry;
+    QElapsedTimer mDecryptionTimer; // time to clipboard
     QString mError;
-    QString mSecret;
-    QTimer mTimer;
-    int mTimeout = 0;
+    SecretBuffer mSecret;
+    QDeadlineTimer mExpiry;
+    qint64 mExpiresAt = 0;
+    quint64 mExpiryId = 0; // in DeadlineScheduler
     std::chrono::seconds mSecretTimeout;
 
     static KlipperUtils::State sKlipperState;
@@ -0,0 +1,172 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "secretbuffer.h"
+#include "plasmapass_debug.h"
+
+#include <QAtomicInteger>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace PlasmaPass;
+
+namespace
+{
+qsizetype pageSize()
+{
+    static const qsizetype size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+qsizetype allocationSize(qsizetype capacity)
+{
+    const auto bytes = capacity * qsizetype(sizeof(QChar));
+    return (bytes + pageSize() - 1) / pageSize() * pageSize();
+}
+
+QChar *allocate(qsizetype bytes)
+{
+    auto memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        qBadAlloc();
+    }
+    if (mlock(memory, bytes) != 0) {
+        // Typically RLIMIT_MEMLOCK is too low, the memory is still wiped when freed
+        static QAtomicInteger<bool> sWarned = false;
+        if (!sWarned.fetchAndStoreRelaxed(true)) {
+            qCWarning(PLASMAPASS_LOG, "Failed to lock memory for secrets, they may be swapped out: %s", strerror(errno));
+        }
+    }
+#ifdef MADV_DONTDUMP
+    madvise(memory, bytes, MADV_DONTDUMP);
+#endif
+    return static_cast<QChar *>(memory);
+}
+
+void release(QChar *data, qsizetype bytes)
+{
+    wipe(data, bytes);
+    munlock(data, bytes);
+    munmap(data, bytes);
+}
+
+} // namespace
+
+void PlasmaPass::wipe(void *memory, size_t size)
+{
+    auto data = static_cast<volatile char *>(memory);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = 0;
+    }
+}
+
+SecretBuffer::SecretBuffer(QStringView text)
+{
+    append(text);
+}
+
+SecretBuffer::~SecretBuffer()
+{
+    clear();
+}
+
+SecretBuffer::SecretBuffer(SecretBuffer &&other) noexcept
+    : mData(std::exchange(other.mData, nullptr))
+    , mSize(std::exchange(other.mSize, 0))
+    , mCapacity(std::exchange(other.mCapacity, 0))
+{
+}
+
+SecretBuffer &SecretBuffer::operator=(SecretBuffer &&other) noexcept
+{
+    if (this != &other) {
+        clear();
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+        mCapacity = std::exchange(other.mCapacity, 0);
+    }
+    return *this;
+}
+
+SecretBuffer SecretBuffer::fromUtf8(QByteArrayView utf8)
+{
+    QStringDecoder decoder(QStringDecoder::Utf8);
+    SecretBuffer buffer;
+    buffer.appendUtf8(decoder, utf8);
+    return buffer;
+}
+
+bool SecretBuffer::isNull() const
+{
+    return mData == nullptr;
+}
+
+qsizetype SecretBuffer::size() const
+{
+    return mSize;
+}
+
+QStringView SecretBuffer::view() const
+{
+    return QStringView(mData, mSize);
+}
+
+QString SecretBuffer::toString() const
+{
+    return isNull() ? QString() : view().toString();
+}
+
+void SecretBuffer::append(QStringView text)
+{
+    reserve(mSize + text.size());
+    std::copy(text.cbegin(), text.cend(), mData + mSize);
+    mSize += text.size();
+}
+
+void SecretBuffer::appendUtf8(QStringDecoder &decoder, QByteArrayView utf8)
+{
+    reserve(mSize + decoder.requiredSpace(utf8.size()));
+    mSize = decoder.appendToBuffer(mData + mSize, utf8) - mData;
+}
+
+void SecretBuffer::truncate(qsizetype size)
+{
+    if (size < mSize) {
+        wipe(mData + size, (mSize - size) * sizeof(QChar));
+        mSize = size;
+    }
+}
+
+void SecretBuffer::clear()
+{
+    if (mData != nullptr) {
+        release(mData, allocationSize(mCapacity));
+    }
+    mData = nullptr;
+    mSize = 0;
+    mCapacity = 0;
+}
+
+void SecretBuffer::reserve(qsizetype capacity)
+{
+    if (mData != nullptr && capacity <= mCapacity) {
+        return;
+    }
+
+    // Grow geometrically, the memory is allocated in whole pages anyway
+    const auto bytes = allocationSize(std::max({capacity, 2 * mCapacity, qsizetype(1)}));
+    auto data = allocate(bytes);
+    if (mData != nullptr) {
+        std::copy(mData, mData + mSize, data);
+        release(mData, allocationSize(mCapacity));
+    }
+    mData = data;
+    mCapacity = bytes / qsizetype(sizeof(QChar));
+}
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef SECRETBUFFER_H_
+#define SECRETBUFFER_H_
+
+#include <QByteArrayView>
+#include <QString>
+#include <QStringDecoder>
+#include <QStringView>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Text of a secret in memory that is never swapped out and is wiped when freed.
+ *
+ * The memory is mapped separately from the rest of the heap, locked (as far as
+ * RLIMIT_MEMLOCK allows) and excluded from core dumps. Whenever the buffer grows,
+ * shrinks or is destroyed, the memory it no longer needs is overwritten with zeros.
+ *
+ * The buffer can be moved but not copied, so a secret is not duplicated by accident
+ * on its way from the decryption to the clipboard. Use toString() only where Qt
+ * requires a QString, the copy it returns is not protected.
+ */
+class SecretBuffer
+{
+public:
+    SecretBuffer() = default;
+    explicit SecretBuffer(QStringView text);
+    ~SecretBuffer();
+
+    SecretBuffer(SecretBuffer &&other) noexcept;
+    SecretBuffer &operator=(SecretBuffer &&other) noexcept;
+    Q_DISABLE_COPY(SecretBuffer)
+
+    static SecretBuffer fromUtf8(QByteArrayView utf8);
+
+    /**
+     * Returns true for a default-constructed or cleared buffer. Anything else, even
+     * empty text, has memory allocated.
+     */
+    bool isNull() const;
+    qsizetype size() const;
+    QStringView view() const;
+    QString toString() const;
+
+    void append(QStringView text);
+    /**
+     * Decodes @p utf8 and appends it, the @p decoder keeps the characters split
+     * between two calls.
+     */
+    void appendUtf8(QStringDecoder &decoder, QByteArrayView utf8);
+    /**
+     * Drops the text after the first @p size characters.
+     */
+    void truncate(qsizetype size);
+    /**
+     * Wipes and frees the memory, the buffer becomes null.
+     */
+    void clear();
+
+private:
+    void reserve(qsizetype capacity);
+
+    QChar *mData = nullptr;
+    qsizetype mSize = 0;
+    qsizetype mCapacity = 0; // in characters
+};
+
+/**
+ * @brief Overwrites @p size bytes at @p memory with zeros.
+ *
+ * Unlike memset() or std::fill(), the compiler cannot leave this out when the memory
+ * is not read anymore afterwards, e.g. right before it is freed or goes out of scope.
+ * Use it for secrets that have to leave a SecretBuffer for a moment.
+ */
+void wipe(void *memory, size_t size);
+
+}
+
+#endif // SECRETBUFFER_H_
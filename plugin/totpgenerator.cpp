@@ -0,0 +1,179 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "totpgenerator.h"
+#include "plasmapass_debug.h"
+
+#include <QUrl>
+#include <QUrlQuery>
+#include <QVarLengthArray>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <liboath/oath.h>
+
+using namespace PlasmaPass;
+
+namespace
+{
+const QString totpType = QStringLiteral("totp");
+const QString secretQueryItemPrefix = QStringLiteral("secret=");
+const QString periodQueryItem = QStringLiteral("period");
+const QString digitsQueryItem = QStringLiteral("digits");
+
+// liboath generates codes of 6 to 8 digits
+constexpr const int minDigits = 6;
+constexpr const int maxDigits = 8;
+
+// Percent-decodes the base32 secret into @p bytes, returns false when it is not ASCII
+bool decodeSecret(QStringView secret, QVarLengthArray<char, 128> &bytes)
+{
+    bytes.resize(secret.size());
+    qsizetype size = 0;
+    for (qsizetype i = 0; i < secret.size(); ++i) {
+        auto c = secret[i].unicode();
+        if (secret[i] == QLatin1Char('%') && i + 2 < secret.size()) {
+            bool ok = false;
+            const auto byte = secret.sliced(i + 1, 2).toUShort(&ok, 16);
+            if (ok) {
+                c = byte;
+                i += 2;
+            }
+        }
+        if (c > 0x7f) {
+            return false;
+        }
+        bytes[size++] = static_cast<char>(c);
+    }
+    // Shrinking keeps the memory, the caller wipes all of it
+    bytes.resize(size);
+    return true;
+}
+
+} // namespace
+
+QString TOTPGenerator::load(QStringView uri)
+{
+    clear();
+
+    // The secret is read straight from the line of the entry. QUrl and QUrlQuery would
+    // leave copies of it on the heap, so only the rest of the URI goes through them.
+    QStringView secret;
+    QString rest;
+    auto withoutFragment = uri;
+    if (const auto fragmentStart = uri.indexOf(QLatin1Char('#')); fragmentStart != -1) {
+        withoutFragment = uri.first(fragmentStart);
+    }
+    const auto queryStart = withoutFragment.indexOf(QLatin1Char('?'));
+    if (queryStart == -1) {
+        rest = withoutFragment.toString();
+    } else {
+        rest = withoutFragment.first(queryStart + 1).toString();
+        QStringList items;
+        for (const auto item : withoutFragment.sliced(queryStart + 1).split(QLatin1Char('&'))) {
+            if (!item.startsWith(secretQueryItemPrefix)) {
+                items.push_back(item.toString());
+            } else if (secret.isNull()) {
+                secret = item.sliced(secretQueryItemPrefix.size());
+            }
+        }
+        rest += items.join(QLatin1Char('&'));
+    }
+
+    const QUrl url(rest);
+    if (url.host() != totpType) {
+        return i18n("Unsupported OTP type %1", url.host());
+    }
+
+    const QUrlQuery query(url.query());
+    bool ok = true;
+    int period = mPeriod;
+    if (query.hasQueryItem(periodQueryItem)) {
+        period = query.queryItemValue(periodQueryItem).toInt(&ok);
+        if (!ok || period <= 0) {
+            return i18n("Invalid OTP period %1", query.queryItemValue(periodQueryItem));
+        }
+    }
+    int digits = mDigits;
+    if (query.hasQueryItem(digitsQueryItem)) {
+        digits = query.queryItemValue(digitsQueryItem).toInt(&ok);
+        if (!ok || digits < minDigits || digits > maxDigits) {
+            return i18n("Unsupported number of OTP digits %1", query.queryItemValue(digitsQueryItem));
+        }
+    }
+
+    QVarLengthArray<char, 128> base32;
+    char *decodedSecret = {};
+    size_t decodedSecretLen = 0;
+    int result = OATH_INVALID_BASE32;
+    if (decodeSecret(secret, base32)) {
+        result = oath_base32_decode(base32.data(), base32.size(), &decodedSecret, &decodedSecretLen);
+    }
+    wipe(base32.data(), base32.capacity());
+    if (result != OATH_OK || decodedSecretLen == 0) {
+        free(decodedSecret);
+        return i18n("Invalid OTP secret");
+    }
+
+    for (size_t i = 0; i < decodedSecretLen; ++i) {
+        const QChar byte(static_cast<uchar>(decodedSecret[i]));
+        mKey.append(QStringView(&byte, 1));
+    }
+    wipe(decodedSecret, decodedSecretLen);
+    free(decodedSecret);
+
+    mPeriod = period;
+    mDigits = digits;
+    return {};
+}
+
+bool TOTPGenerator::isNull() const
+{
+    return mKey.isNull();
+}
+
+int TOTPGenerator::period() const
+{
+    return mPeriod;
+}
+
+SecretBuffer TOTPGenerator::code(qint64 time) const
+{
+    if (mKey.isNull()) {
+        return {};
+    }
+
+    // liboath wants the key in one piece, it lives on the stack only for this one HMAC
+    QVarLengthArray<char, 64> key(mKey.size());
+    std::transform(mKey.view().cbegin(), mKey.view().cend(), key.begin(), [](QChar byte) {
+        return static_cast<char>(byte.unicode());
+    });
+
+    char output[maxDigits + 1] = {}; // the code and its terminating null
+    const auto result = oath_totp_generate(key.constData(), key.size(), time, mPeriod, OATH_TOTP_DEFAULT_START_TIME, mDigits, output);
+    wipe(key.data(), key.size());
+    if (result != OATH_OK) {
+        qCWarning(PLASMAPASS_LOG, "Failed to generate TOTP code: %s", oath_strerror(result));
+        return {};
+    }
+
+    auto code = SecretBuffer::fromUtf8(QByteArrayView(output, mDigits));
+    wipe(output, sizeof(output));
+    return code;
+}
+
+qint64 TOTPGenerator::nextStep(qint64 time) const
+{
+    return (time / mPeriod + 1) * mPeriod;
+}
+
+void TOTPGenerator::clear()
+{
+    mKey.clear();
+    mPeriod = 30;
+    mDigits = 6;
+}
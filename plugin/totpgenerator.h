@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef TOTPGENERATOR_H_
+#define TOTPGENERATOR_H_
+
+#include "secretbuffer.h"
+
+#include <QString>
+#include <QStringView>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Generates TOTP codes from the key of an otpauth://totp/ URI.
+ *
+ * The key is base32-decoded once, when the URI is loaded, and kept in a SecretBuffer,
+ * one byte of the key in each character. Generating a code is then just one HMAC,
+ * without decrypting the entry again.
+ */
+class TOTPGenerator
+{
+public:
+    TOTPGenerator() = default;
+
+    /**
+     * Loads the key, the period and the number of digits from @p uri. Returns an error
+     * message, or a null string on success.
+     */
+    QString load(QStringView uri);
+
+    bool isNull() const;
+    int period() const; // in seconds
+
+    /**
+     * Returns the code for @p time in seconds since the epoch, a null buffer when it
+     * cannot be generated.
+     */
+    SecretBuffer code(qint64 time) const;
+
+    /**
+     * Returns when the step after the one @p time falls into starts, in seconds since the epoch.
+     */
+    qint64 nextStep(qint64 time) const;
+
+    /**
+     * Wipes the key.
+     */
+    void clear();
+
+private:
+    SecretBuffer mKey;
+    int mPeriod = 30;
+    int mDigits = 6;
+};
+
+}
+
+#endif // TOTPGENERATOR_H_
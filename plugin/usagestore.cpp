@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "usagestore.h"
+#include "plasmapass_debug.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPointer>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace PlasmaPass;
+using namespace std::chrono_literals;
+
+namespace
+{
+constexpr const quint32 usageFileMagic = 0x50505553; // "PPUS"
+constexpr const quint8 usageFileVersion = 1;
+constexpr const auto saveDelay = 5s;
+
+// Score of an entry halves every week it is not used
+constexpr const double halfLifeDays = 7.0;
+const double decayRate = std::log(2.0) / halfLifeDays;
+// Entries whose decayed copy count drops below this are forgotten when saving
+const double minimumScore = std::log(0.05);
+
+constexpr const double secondsPerDay = 24.0 * 60.0 * 60.0;
+
+// Current time, in the units used by the decay rate, relative to the Unix epoch
+double now()
+{
+    return static_cast<double>(QDateTime::currentSecsSinceEpoch()) / secondsPerDay;
+}
+
+// log(exp(a) + exp(b)) without overflowing
+double logAddExp(double a, double b)
+{
+    if (std::isinf(a) && a < 0) {
+        return b;
+    }
+    const auto [lo, hi] = std::minmax(a, b);
+    return hi + std::log1p(std::exp(lo - hi));
+}
+
+} // namespace
+
+UsageStore *UsageStore::instance()
+{
+    static QPointer<UsageStore> sInstance;
+    if (sInstance.isNull()) {
+        sInstance = new UsageStore(QCoreApplication::instance());
+    }
+    return sInstance;
+}
+
+UsageStore::UsageStore(QObject *parent)
+    : QObject(parent)
+    , mFilePath(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/plasma-pass/usage"))
+{
+    mSaveTimer.setSingleShot(true);
+    mSaveTimer.setInterval(saveDelay);
+    connect(&mSaveTimer, &QTimer::timeout, this, &UsageStore::save);
+
+    load();
+}
+
+UsageStore::~UsageStore()
+{
+    if (mSaveTimer.isActive()) {
+        save();
+    }
+}
+
+void UsageStore::recordUsage(const QString &fullName)
+{
+    auto it = mScores.find(fullName);
+    if (it == mScores.end()) {
+        it = mScores.insert(fullName, -std::numeric_limits<double>::infinity());
+    }
+    *it = logAddExp(*it, decayRate * now());
+
+    mSaveTimer.start();
+    Q_EMIT usageChanged();
+}
+
+double UsageStore::score(const QString &fullName) const
+{
+    return mScores.value(fullName, -std::numeric_limits<double>::infinity());
+}
+
+void UsageStore::load()
+{
+    QFile file(mFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint8 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != usageFileMagic || version != usageFileVersion) {
+        qCWarning(PLASMAPASS_LOG, "Ignoring usage file %s with unknown format", qUtf8Printable(mFilePath));
+        return;
+    }
+
+    mScores.reserve(count);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString fullName;
+        double score = 0.0;
+        stream >> fullName >> score;
+        mScores.insert(fullName, score);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(PLASMAPASS_LOG, "Usage file %s is corrupted", qUtf8Printable(mFilePath));
+        mScores.clear();
+    }
+}
+
+void UsageStore::save()
+{
+    mSaveTimer.stop();
+
+    // Forget entries that have not been used for so long that they no longer affect the ranking
+    const double threshold = decayRate * now() + minimumScore;
+    mScores.removeIf([threshold](QHash<QString, double>::iterator it) {
+        return it.value() < threshold;
+    });
+
+    if (!QDir().mkpath(QFileInfo(mFilePath).absolutePath())) {
+        qCWarning(PLASMAPASS_LOG, "Failed to create directory for usage file %s", qUtf8Printable(mFilePath));
+        return;
+    }
+
+    QSaveFile file(mFilePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(PLASMAPASS_LOG, "Failed to open usage file: %s", qUtf8Printable(file.errorString()));
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << usageFileMagic << usageFileVersion << static_cast<quint32>(mScores.size());
+    for (auto it = mScores.cbegin(), end = mScores.cend(); it != end; ++it) {
+        stream << it.key() << it.value();
+    }
+
+    if (!file.commit()) {
+        qCWarning(PLASMAPASS_LOG, "Failed to write usage file: %s", qUtf8Printable(file.errorString()));
+    }
+}
+
+#include "moc_usagestore.cpp"
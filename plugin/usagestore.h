@@ -0,0 +1,61 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef USAGESTORE_H_
+#define USAGESTORE_H_
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+namespace PlasmaPass
+{
+/**
+ * @brief Remembers how often and how recently each entry has been copied.
+ *
+ * Each entry has a frecency score that grows with every copy and decays exponentially
+ * over time. The score is stored as the logarithm of the decayed copy count relative to
+ * a fixed epoch, so it never needs to be decayed in place and scores recorded at
+ * different times can be compared directly. A lookup is a single hash lookup.
+ *
+ * The scores are persisted in a small binary file in the user's data directory.
+ */
+class UsageStore : public QObject
+{
+    Q_OBJECT
+public:
+    static UsageStore *instance();
+
+    ~UsageStore() override;
+
+    /**
+     * @brief Records that entry @p fullName (relative to the password store) has just been copied.
+     */
+    void recordUsage(const QString &fullName);
+
+    /**
+     * @brief Returns the frecency score of the given entry, higher is more frecent.
+     *
+     * Returns a negative infinity for entries that have never been used.
+     */
+    double score(const QString &fullName) const;
+
+Q_SIGNALS:
+    void usageChanged();
+
+private:
+    explicit UsageStore(QObject *parent = nullptr);
+
+    void load();
+    void save();
+
+    QString mFilePath;
+    QHash<QString, double> mScores;
+    QTimer mSaveTimer;
+};
+
+}
+
+#endif // USAGESTORE_H_
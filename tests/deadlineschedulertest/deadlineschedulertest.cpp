@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "deadlinescheduler.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <chrono>
+#include <memory>
+
+using namespace PlasmaPass;
+using namespace std::chrono_literals;
+
+class DeadlineSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testOrder()
+    {
+        auto scheduler = DeadlineScheduler::instance();
+        QList<int> fired;
+        scheduler->schedule(QDeadlineTimer(300ms), this, [&fired]() {
+            fired.push_back(3);
+        });
+        scheduler->schedule(QDeadlineTimer(100ms), this, [&fired]() {
+            fired.push_back(1);
+        });
+        scheduler->schedule(QDeadlineTimer(200ms), this, [&fired]() {
+            fired.push_back(2);
+        });
+
+        QTRY_COMPARE_WITH_TIMEOUT(fired.size(), 3, 5000);
+        QCOMPARE(fired, (QList<int>{1, 2, 3}));
+    }
+
+    void testCancel()
+    {
+        auto scheduler = DeadlineScheduler::instance();
+        QList<int> fired;
+        const auto nearest = scheduler->schedule(QDeadlineTimer(50ms), this, [&fired]() {
+            fired.push_back(1);
+        });
+        scheduler->schedule(QDeadlineTimer(150ms), this, [&fired]() {
+            fired.push_back(2);
+        });
+        // Canceling the nearest deadline re-arms the timer for the next one
+        scheduler->cancel(nearest);
+        scheduler->cancel(0);
+
+        QTRY_COMPARE_WITH_TIMEOUT(fired.size(), 1, 5000);
+        QCOMPARE(fired, (QList<int>{2}));
+    }
+
+    void testCancelDue()
+    {
+        auto scheduler = DeadlineScheduler::instance();
+        QList<int> fired;
+        // Both pass at once, the first one is called back first and cancels the second
+        const QDeadlineTimer deadline(50ms);
+        DeadlineScheduler::Id second = 0;
+        scheduler->schedule(deadline, this, [&fired, &second, scheduler]() {
+            fired.push_back(1);
+            scheduler->cancel(second);
+        });
+        second = scheduler->schedule(deadline, this, [&fired]() {
+            fired.push_back(2);
+        });
+        scheduler->schedule(QDeadlineTimer(150ms), this, [&fired]() {
+            fired.push_back(3);
+        });
+
+        QTRY_COMPARE_WITH_TIMEOUT(fired.size(), 2, 5000);
+        QCOMPARE(fired, (QList<int>{1, 3}));
+    }
+
+    void testDestroyedContext()
+    {
+        auto scheduler = DeadlineScheduler::instance();
+        bool fired = false;
+        bool laterFired = false;
+        auto context = std::make_unique<QObject>();
+        scheduler->schedule(QDeadlineTimer(50ms), context.get(), [&fired]() {
+            fired = true;
+        });
+        scheduler->schedule(QDeadlineTimer(100ms), this, [&laterFired]() {
+            laterFired = true;
+        });
+        context.reset();
+
+        QTRY_VERIFY_WITH_TIMEOUT(laterFired, 5000);
+        QVERIFY(!fired);
+    }
+
+    void testPassedDeadline()
+    {
+        bool fired = false;
+        DeadlineScheduler::instance()->schedule(QDeadlineTimer(0), this, [&fired]() {
+            fired = true;
+        });
+        QVERIFY(!fired); // always asynchronous
+        QTRY_VERIFY_WITH_TIMEOUT(fired, 5000);
+    }
+};
+
+QTEST_GUILESS_MAIN(DeadlineSchedulerTest)
+
+#include "deadlineschedulertest.moc"
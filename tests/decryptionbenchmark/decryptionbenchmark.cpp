@@ -0,0 +1,128 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "decryptionservice.h"
+#include "gpgtestenv.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <QGpgME/DecryptJob>
+#include <QGpgME/Protocol>
+#include <gpgme++/decryptionresult.h>
+
+#include <memory>
+
+using namespace PlasmaPass;
+
+namespace
+{
+constexpr const int iterations = 5;
+constexpr const qsizetype largeEntrySize = 16 * 1024 * 1024;
+
+} // namespace
+
+class DecryptionBenchmark : public QObject
+{
+    Q_OBJECT
+
+    QString encrypt(const QString &name, const QByteArray &plainText)
+    {
+        const auto path = mDir.filePath(name + QStringLiteral(".gpg"));
+        return mGpg.encrypt(plainText, path) ? path : QString();
+    }
+
+    GpgTestEnv mGpg;
+    QTemporaryDir mDir;
+    int mCopies = 0;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        if (!GpgTestEnv::isAvailable()) {
+            QSKIP("gpg is not installed");
+        }
+        QVERIFY(mDir.isValid());
+        QVERIFY(mGpg.init());
+    }
+
+    void benchmarkTimeToFirstLine_data()
+    {
+        QTest::addColumn<QString>("path");
+        QTest::addColumn<bool>("streaming");
+
+        const auto small = encrypt(QStringLiteral("small"), QByteArrayLiteral("password\nlogin: user\nurl: https://example.org\n"));
+        QVERIFY(!small.isEmpty());
+
+        // An entry with large notes, e.g. a pasted document
+        QByteArray notes("password\n");
+        notes.reserve(largeEntrySize);
+        while (notes.size() < largeEntrySize) {
+            notes.append("Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor.\n");
+        }
+        const auto large = encrypt(QStringLiteral("large"), notes);
+        QVERIFY(!large.isEmpty());
+
+        QTest::newRow("small, whole file") << small << false;
+        QTest::newRow("small, streaming") << small << true;
+        QTest::newRow("large, whole file") << large << false;
+        QTest::newRow("large, streaming") << large << true;
+    }
+
+    // Time from starting the decryption until the password (the first line) is known
+    void benchmarkTimeToFirstLine()
+    {
+        QFETCH(QString, path);
+        QFETCH(bool, streaming);
+
+        qint64 elapsed = 0;
+        for (int i = 0; i < iterations; ++i) {
+            // A fresh copy each time, so that the service cannot join the previous decryption
+            const auto copy = mDir.filePath(QStringLiteral("copy%1.gpg").arg(mCopies++));
+            QVERIFY(QFile::copy(path, copy));
+
+            QString firstLine;
+            QElapsedTimer timer;
+            timer.start();
+            if (streaming) {
+                QEventLoop loop;
+                DecryptionService::instance()->decrypt(
+                    copy,
+                    &loop,
+                    [&firstLine, &loop](QStringView line) {
+                        firstLine = line.toString();
+                        loop.quit();
+                        return true;
+                    },
+                    [&loop](const QString &error) {
+                        qWarning() << "Decryption failed:" << error;
+                        loop.quit();
+                    });
+                loop.exec();
+            } else {
+                // What ProviderBase used to do: decrypt all of the file, then split it into lines
+                QFile file(copy);
+                QVERIFY(file.open(QIODevice::ReadOnly));
+                QByteArray plainText;
+                const std::unique_ptr<QGpgME::DecryptJob> job(QGpgME::openpgp()->decryptJob());
+                const auto result = job->exec(file.readAll(), plainText);
+                QVERIFY(!result.error());
+                firstLine = QString::fromUtf8(plainText).split(QLatin1Char('\n')).constFirst();
+            }
+            elapsed += timer.nsecsElapsed();
+            QCOMPARE(firstLine, QStringLiteral("password"));
+        }
+
+        QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / iterations / 1e6, QTest::WalltimeMilliseconds);
+    }
+};
+
+QTEST_GUILESS_MAIN(DecryptionBenchmark)
+
+#include "decryptionbenchmark.moc"
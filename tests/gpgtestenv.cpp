@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "gpgtestenv.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QStringList>
+
+namespace
+{
+const QString keyUid = QStringLiteral("Plasma Pass Test <test@example.org>");
+
+bool runGpg(const QStringList &arguments)
+{
+    QProcess gpg;
+    gpg.start(QStringLiteral("gpg"), QStringList{QStringLiteral("--batch"), QStringLiteral("--quiet")} + arguments);
+    return gpg.waitForFinished(60000) && gpg.exitStatus() == QProcess::NormalExit && gpg.exitCode() == 0;
+}
+
+} // namespace
+
+GpgTestEnv::~GpgTestEnv()
+{
+    if (mInitialized) {
+        QProcess::execute(QStringLiteral("gpgconf"), {QStringLiteral("--kill"), QStringLiteral("gpg-agent")});
+    }
+}
+
+bool GpgTestEnv::isAvailable()
+{
+    return !QStandardPaths::findExecutable(QStringLiteral("gpg")).isEmpty();
+}
+
+bool GpgTestEnv::init()
+{
+    if (!mDir.isValid()) {
+        return false;
+    }
+
+    const auto home = mDir.filePath(QStringLiteral("gnupg"));
+    if (!QDir().mkpath(home)) {
+        return false;
+    }
+    QFile::setPermissions(home, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    qputenv("GNUPGHOME", QFile::encodeName(home));
+    mInitialized = true;
+    return runGpg({QStringLiteral("--pinentry-mode"),
+                   QStringLiteral("loopback"),
+                   QStringLiteral("--passphrase"),
+                   QString(),
+                   QStringLiteral("--quick-generate-key"),
+                   keyUid,
+                   QStringLiteral("default"),
+                   QStringLiteral("default"),
+                   QStringLiteral("never")});
+}
+
+bool GpgTestEnv::encrypt(const QByteArray &plainText, const QString &path)
+{
+    const auto plainPath = mDir.filePath(QStringLiteral("plain"));
+    QFile file(plainPath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(plainText) != plainText.size()) {
+        return false;
+    }
+    file.close();
+
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+    return runGpg({QStringLiteral("--yes"),
+                   QStringLiteral("--trust-model"),
+                   QStringLiteral("always"),
+                   QStringLiteral("--recipient"),
+                   keyUid,
+                   QStringLiteral("--output"),
+                   path,
+                   QStringLiteral("--encrypt"),
+                   plainPath});
+}
@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#ifndef GPGTESTENV_H_
+#define GPGTESTENV_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryDir>
+
+/**
+ * @brief Throwaway GnuPG keyring for the tests that decrypt real password files.
+ *
+ * The keyring lives in a temporary directory and has a single key without passphrase,
+ * so no pinentry is needed. The gpg-agent started for it is stopped when the
+ * environment is destroyed.
+ */
+class GpgTestEnv
+{
+public:
+    GpgTestEnv() = default;
+    ~GpgTestEnv();
+
+    /**
+     * Whether gpg is installed, the tests are skipped when it is not.
+     */
+    static bool isAvailable();
+
+    /**
+     * Creates the keyring and points GNUPGHOME at it.
+     */
+    bool init();
+
+    /**
+     * Encrypts @p plainText to the key of the keyring into the file at @p path,
+     * creating its folder and replacing the file if it exists.
+     */
+    bool encrypt(const QByteArray &plainText, const QString &path);
+
+private:
+    QTemporaryDir mDir;
+    bool mInitialized = false;
+};
+
+#endif // GPGTESTENV_H_
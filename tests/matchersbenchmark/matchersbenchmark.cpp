@@ -0,0 +1,590 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "abbreviations.h"
+#include "parallelchunks.h"
+
+#include <QCollator>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QTest>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace PlasmaPass;
+
+namespace
+{
+constexpr const quint32 seed = 42;
+
+QString pick(QRandomGenerator &rng, const QStringList &list)
+{
+    return list.at(rng.bounded(list.size()));
+}
+
+QString randomWord(QRandomGenerator &rng, int length)
+{
+    QString word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.append(QLatin1Char(static_cast<char>('a' + rng.bounded(26))));
+    }
+    return word;
+}
+
+// Paths shaped like those in a typical password store
+QStringList realisticCorpus(int count)
+{
+    static const QStringList folders = {QStringLiteral("work"), QStringLiteral("personal"), QStringLiteral("servers"), QStringLiteral("banking"),
+                                        QStringLiteral("social"), QStringLiteral("shopping"), QStringLiteral("dev"), QStringLiteral("family")};
+    static const QStringList services = {QStringLiteral("aws"), QStringLiteral("gcp"), QStringLiteral("github.com"), QStringLiteral("gitlab"),
+                                         QStringLiteral("google"), QStringLiteral("mail"), QStringLiteral("prod"), QStringLiteral("staging"),
+                                         QStringLiteral("db"), QStringLiteral("vpn"), QStringLiteral("KeePassXC"), QStringLiteral("my-bank")};
+    static const QStringList names = {QStringLiteral("admin"), QStringLiteral("root"), QStringLiteral("deploy"), QStringLiteral("jenkins"),
+                                      QStringLiteral("john.doe"), QStringLiteral("ci-bot"), QStringLiteral("readonly"), QStringLiteral("backup_user"),
+                                      QStringLiteral("DatabaseAdmin"), QStringLiteral("api-token")};
+
+    QRandomGenerator rng(seed);
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QStringList segments;
+        const int depth = rng.bounded(1, 4);
+        for (int d = 0; d < depth; ++d) {
+            segments.push_back(pick(rng, d == 0 ? folders : services));
+        }
+        segments.push_back(pick(rng, names) + QString::number(rng.bounded(100)));
+        corpus.push_back(segments.join(QLatin1Char('/')));
+    }
+    return corpus;
+}
+
+QStringList deepCorpus(int count)
+{
+    QRandomGenerator rng(seed);
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QStringList segments;
+        for (int d = 0; d < 24; ++d) {
+            segments.push_back(randomWord(rng, 6));
+        }
+        corpus.push_back(segments.join(QLatin1Char('/')));
+    }
+    return corpus;
+}
+
+QStringList longSegmentsCorpus(int count)
+{
+    QRandomGenerator rng(seed);
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        corpus.push_back(randomWord(rng, 200) + QLatin1Char('/') + randomWord(rng, 200));
+    }
+    return corpus;
+}
+
+QStringList wordBoundariesCorpus(int count)
+{
+    QRandomGenerator rng(seed);
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString name;
+        for (int w = 0; w < 30; ++w) {
+            if (w % 3 == 0) {
+                name += QLatin1Char('-');
+            } else if (w % 3 == 1) {
+                name += QLatin1Char('_');
+            }
+            auto word = randomWord(rng, 3);
+            word[0] = word[0].toUpper();
+            name += word;
+        }
+        corpus.push_back(QStringLiteral("boundaries/") + name);
+    }
+    return corpus;
+}
+
+QStringList nonAsciiCorpus(int count)
+{
+    static const QStringList words = {QStringLiteral("Bücherei"), QStringLiteral("Ñandú"), QStringLiteral("Москва"), QStringLiteral("東京"),
+                                      QStringLiteral("Ελλάδα"), QStringLiteral("straße"), QStringLiteral("Příliš-žluťoučký"), QStringLiteral("ｆｕｌｌｗｉｄｔｈ")};
+    QRandomGenerator rng(seed);
+    QStringList corpus;
+    corpus.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        corpus.push_back(pick(rng, words) + QLatin1Char('/') + pick(rng, words) + QString::number(i));
+    }
+    return corpus;
+}
+
+// An abbreviation where each typed letter matches both the next letter in the current word
+// and the beginning of the next word, so the matcher has to branch on every letter. There
+// are more typed letters than the word has, so it only fails once all branches are exhausted.
+QString adversarialWord()
+{
+    QStringList words;
+    for (int i = 0; i < 64; ++i) {
+        words.push_back(QStringLiteral("aa"));
+    }
+    return words.join(QLatin1Char('-'));
+}
+
+QString adversarialTyped()
+{
+    return QString(150, QLatin1Char('a'));
+}
+
+// Reports the average time spent per corpus entry once the benchmark finishes
+class PerEntryReporter
+{
+public:
+    explicit PerEntryReporter(qsizetype entries)
+        : mEntries(entries)
+    {
+        mTimer.start();
+    }
+
+    ~PerEntryReporter()
+    {
+        if (mIterations > 0 && mEntries > 0) {
+            const double nsPerEntry = static_cast<double>(mTimer.nsecsElapsed()) / static_cast<double>(mIterations * mEntries);
+            qInfo("%s: %.1f ns/entry", QTest::currentDataTag(), nsPerEntry);
+        }
+    }
+
+    PerEntryReporter(const PerEntryReporter &) = delete;
+    PerEntryReporter &operator=(const PerEntryReporter &) = delete;
+
+    void iterationDone()
+    {
+        ++mIterations;
+    }
+
+private:
+    QElapsedTimer mTimer;
+    qsizetype mEntries = 0;
+    qint64 mIterations = 0;
+};
+
+QList<int> unpackRanges(const MatchRanges &matchRanges)
+{
+    QList<int> result;
+    for (const auto range : matchRanges) {
+        result << static_cast<int>(range >> 16) << static_cast<int>(range & 0xFFFF);
+    }
+    return result;
+}
+
+} // namespace
+
+class MatchersBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    static QStringList pathFilterQueries()
+    {
+        return {QStringLiteral("a"),
+                QStringLiteral("github"),
+                QStringLiteral("w/aws/adm"),
+                QStringLiteral("DA"),
+                QStringLiteral("bü"),
+                QStringLiteral("москва"),
+                QStringLiteral("nomatchatall")};
+    }
+
+    void addCorpora(const QStringList &queries)
+    {
+        const QList<std::pair<const char *, QStringList>> corpora = {
+            {"realistic", realisticCorpus(10000)},
+            {"deep", deepCorpus(1000)},
+            {"long segments", longSegmentsCorpus(1000)},
+            {"word boundaries", wordBoundariesCorpus(1000)},
+            {"non-ascii", nonAsciiCorpus(5000)},
+        };
+        for (const auto &[name, corpus] : corpora) {
+            for (const auto &query : queries) {
+                QTest::addRow("%s, '%s'", name, qUtf8Printable(query)) << corpus << query;
+            }
+        }
+    }
+
+private Q_SLOTS:
+    void benchmarkMatchPathFilter_data()
+    {
+        QTest::addColumn<QStringList>("corpus");
+        QTest::addColumn<QString>("query");
+
+        addCorpora(pathFilterQueries());
+    }
+
+    void benchmarkMatchPathFilter()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        const auto parts = QStringView(query).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+        int matches = 0;
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            matches = 0;
+            for (const auto &path : std::as_const(corpus)) {
+                if (matchPathFilter(QStringView(path).split(QLatin1Char('/')), parts) > -1) {
+                    ++matches;
+                }
+            }
+            reporter.iterationDone();
+        }
+        QVERIFY(matches <= corpus.size());
+    }
+
+    void benchmarkMatchPathFilterLatin1_data()
+    {
+        benchmarkMatchPathFilter_data();
+    }
+
+    // Same as benchmarkMatchPathFilter, but takes the Latin-1 path for entries that allow it,
+    // the way PasswordFilterModel does
+    void benchmarkMatchPathFilterLatin1()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        QList<QByteArray> latin1Corpus;
+        latin1Corpus.reserve(corpus.size());
+        for (const auto &path : std::as_const(corpus)) {
+            latin1Corpus.push_back(isLatin1(path) ? path.toLatin1() : QByteArray{});
+        }
+        const auto parts = QStringView(query).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+        const auto latin1Query = isLatin1(query) ? query.toLatin1() : QByteArray{};
+        const auto latin1Parts = splitPath(QLatin1StringView(latin1Query), Qt::SkipEmptyParts);
+
+        int matches = 0;
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            matches = 0;
+            for (qsizetype i = 0; i < corpus.size(); ++i) {
+                int weight = -1;
+                if (!latin1Parts.isEmpty() && !latin1Corpus.at(i).isNull()) {
+                    weight = matchPathFilter(splitPath(QLatin1StringView(latin1Corpus.at(i))), latin1Parts);
+                } else {
+                    weight = matchPathFilter(QStringView(corpus.at(i)).split(QLatin1Char('/')), parts);
+                }
+                if (weight > -1) {
+                    ++matches;
+                }
+            }
+            reporter.iterationDone();
+        }
+        QVERIFY(matches <= corpus.size());
+    }
+
+    void testLatin1MatchesUtf16_data()
+    {
+        QTest::addColumn<QStringList>("corpus");
+        QTest::addColumn<QString>("query");
+
+        addCorpora(pathFilterQueries()
+                   + QStringList{QStringLiteral("ÑANDÚ"), QStringLiteral("STRASSE"), QStringLiteral("kpxc"), QStringLiteral("aNF"), QStringLiteral("gthb")});
+    }
+
+    void testLatin1MatchesUtf16()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        if (!isLatin1(query)) {
+            QSKIP("Query is not Latin-1");
+        }
+        const auto latin1Query = query.toLatin1();
+        const auto parts = QStringView(query).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+        const auto latin1Parts = splitPath(QLatin1StringView(latin1Query), Qt::SkipEmptyParts);
+        QCOMPARE(latin1Parts.size(), parts.size());
+
+        for (const auto &path : std::as_const(corpus)) {
+            if (!isLatin1(path)) {
+                continue;
+            }
+            const auto latin1Path = path.toLatin1();
+            const auto segments = QStringView(path).split(QLatin1Char('/'));
+            const auto latin1Segments = splitPath(QLatin1StringView(latin1Path));
+            QCOMPARE(latin1Segments.size(), segments.size());
+            QCOMPARE(matchPathFilter(latin1Segments, latin1Parts), matchPathFilter(segments, parts));
+            QCOMPARE(matchesPath(QLatin1StringView(latin1Path), QLatin1StringView(latin1Query)), matchesPath(path, query));
+            for (qsizetype i = 0; i < segments.size(); ++i) {
+                if (!segments.at(i).isEmpty() && !query.isEmpty()) {
+                    QCOMPARE(matchesAbbreviation(latin1Segments.at(i), QLatin1StringView(latin1Query)), matchesAbbreviation(segments.at(i), query));
+                }
+            }
+        }
+    }
+
+    void benchmarkParallelMatching_data()
+    {
+        QTest::addColumn<int>("threads");
+        QTest::addColumn<bool>("chunked");
+
+        // What the filter did before: one task per entry, reduced into a hash under a lock
+        QTest::newRow("mappedReduced") << QThread::idealThreadCount() << false;
+        for (int threads = 1; threads < QThread::idealThreadCount(); threads *= 2) {
+            QTest::addRow("chunked, %d threads", threads) << threads << true;
+        }
+        QTest::addRow("chunked, %d threads", QThread::idealThreadCount()) << QThread::idealThreadCount() << true;
+    }
+
+    void benchmarkParallelMatching()
+    {
+        QFETCH(int, threads);
+        QFETCH(bool, chunked);
+
+        const auto corpus = realisticCorpus(100000);
+        const auto query = QStringLiteral("w/aws/adm");
+        const auto parts = QStringView(query).split(QLatin1Char('/'), Qt::SkipEmptyParts);
+        const auto match = [&corpus, &parts](int row) {
+            return matchPathFilter(QStringView(corpus.at(row)).split(QLatin1Char('/')), parts);
+        };
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        std::vector<int> rows(corpus.size());
+        std::iota(rows.begin(), rows.end(), 0);
+
+        qsizetype matches = 0;
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            if (chunked) {
+                std::vector<int> weights(corpus.size(), -1);
+                blockingMapChunks(
+                    static_cast<int>(corpus.size()),
+                    [&match, &weights](int first, int last) {
+                        for (int row = first; row < last; ++row) {
+                            weights[row] = match(row);
+                        }
+                    },
+                    DefaultChunkSize,
+                    &pool);
+                matches = std::count_if(weights.cbegin(), weights.cend(), [](int weight) {
+                    return weight > -1;
+                });
+            } else {
+                const auto weights = QtConcurrent::blockingMappedReduced<QHash<int, int>>(
+                    &pool,
+                    rows,
+                    [&match](int row) {
+                        return std::make_pair(row, match(row));
+                    },
+                    [](QHash<int, int> &result, const std::pair<int, int> &value) {
+                        result.insert(value.first, value.second);
+                    });
+                matches = std::count_if(weights.cbegin(), weights.cend(), [](int weight) {
+                    return weight > -1;
+                });
+            }
+            reporter.iterationDone();
+        }
+        QVERIFY(matches > 0);
+    }
+
+    void benchmarkMatchesAbbreviation_data()
+    {
+        QTest::addColumn<QStringList>("corpus");
+        QTest::addColumn<QString>("query");
+
+        addCorpora({QStringLiteral("a"), QStringLiteral("DA"), QStringLiteral("aNF"), QStringLiteral("kpxc")});
+        QTest::newRow("adversarial") << QStringList{adversarialWord()} << adversarialTyped();
+    }
+
+    void benchmarkMatchesAbbreviation()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            for (const auto &word : std::as_const(corpus)) {
+                matchesAbbreviation(word, query);
+            }
+            reporter.iterationDone();
+        }
+    }
+
+    void benchmarkMatchesPath_data()
+    {
+        QTest::addColumn<QStringList>("corpus");
+        QTest::addColumn<QString>("query");
+
+        addCorpora({QStringLiteral("a"), QStringLiteral("gthb"), QStringLiteral("zzzzzzzz")});
+    }
+
+    void benchmarkMatchesPath()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            for (const auto &path : std::as_const(corpus)) {
+                matchesPath(path, query);
+            }
+            reporter.iterationDone();
+        }
+    }
+
+    void benchmarkFuzzyMatcher_data()
+    {
+        QTest::addColumn<QStringList>("corpus");
+        QTest::addColumn<QString>("query");
+
+        addCorpora({QStringLiteral("gihtub"), QStringLiteral("databseadmin"), QStringLiteral("bucherei")});
+    }
+
+    void benchmarkFuzzyMatcher()
+    {
+        QFETCH(QStringList, corpus);
+        QFETCH(QString, query);
+
+        QStringList folded;
+        folded.reserve(corpus.size());
+        for (const auto &path : std::as_const(corpus)) {
+            folded.push_back(path.toCaseFolded());
+        }
+        const auto foldedQuery = query.toCaseFolded();
+        const FuzzyMatcher matcher(foldedQuery, FuzzyMatcher::errorsForLength(foldedQuery.size()));
+
+        PerEntryReporter reporter(folded.size());
+        QBENCHMARK {
+            for (const auto &path : std::as_const(folded)) {
+                matcher.match(path);
+            }
+            reporter.iterationDone();
+        }
+    }
+
+    void testAbbreviationBacktrackingIsBounded()
+    {
+        // Without the depth limit this would take exponential time
+        QVERIFY(!matchesAbbreviation(adversarialWord(), adversarialTyped()));
+    }
+
+    void testMatchRanges_data()
+    {
+        QTest::addColumn<QString>("path");
+        QTest::addColumn<QString>("query");
+        QTest::addColumn<QList<int>>("ranges");
+
+        QTest::newRow("substrings") << QStringLiteral("work/aws/admin1") << QStringLiteral("w/aws/adm") << QList<int>{0, 1, 5, 3, 9, 3};
+        QTest::newRow("subsequence") << QStringLiteral("x/DatabaseAdmin") << QStringLiteral("dbadm") << QList<int>{2, 1, 6, 2, 11, 2};
+        QTest::newRow("abbreviation") << QStringLiteral("KeePassXC/root") << QStringLiteral("kpxc/r") << QList<int>{0, 1, 3, 1, 7, 2, 10, 1};
+        QTest::newRow("no match") << QStringLiteral("work/aws") << QStringLiteral("gcp") << QList<int>{};
+    }
+
+    void testMatchRanges()
+    {
+        QFETCH(QString, path);
+        QFETCH(QString, query);
+        QFETCH(QList<int>, ranges);
+
+        MatchRanges utf16Ranges;
+        matchPathFilter(QStringView(path).split(QLatin1Char('/')), QStringView(query).split(QLatin1Char('/'), Qt::SkipEmptyParts), &utf16Ranges);
+        QCOMPARE(unpackRanges(utf16Ranges), ranges);
+
+        const auto latin1Path = path.toLatin1();
+        const auto latin1Query = query.toLatin1();
+        MatchRanges latin1Ranges;
+        matchPathFilter(splitPath(QLatin1StringView(latin1Path)), splitPath(QLatin1StringView(latin1Query), Qt::SkipEmptyParts), &latin1Ranges);
+        QCOMPARE(unpackRanges(latin1Ranges), ranges);
+    }
+
+    void testNormalizedMatchRanges_data()
+    {
+        QTest::addColumn<QString>("path");
+        QTest::addColumn<QString>("query");
+        QTest::addColumn<QList<int>>("ranges");
+
+        QTest::newRow("precomposed") << QStringLiteral("web/B\u00FCcherei") << QStringLiteral("bucherei") << QList<int>{4, 8};
+        QTest::newRow("decomposed") << QStringLiteral("web/Bu\u0308cherei") << QStringLiteral("bucherei") << QList<int>{4, 9};
+        QTest::newRow("query with diacritics") << QStringLiteral("web/Bucherei") << QStringLiteral("b\u00FCcherei") << QList<int>{4, 8};
+        QTest::newRow("full-width") << QStringLiteral("dev/\uFF27\uFF49\uFF54\uFF48\uFF55\uFF42") << QStringLiteral("github") << QList<int>{4, 6};
+        QTest::newRow("ligature") << QStringLiteral("\uFB01les") << QStringLiteral("fil") << QList<int>{0, 2};
+        QTest::newRow("part of ligature") << QStringLiteral("\uFB01les") << QStringLiteral("f") << QList<int>{0, 1};
+    }
+
+    void testNormalizedMatchRanges()
+    {
+        QFETCH(QString, path);
+        QFETCH(QString, query);
+        QFETCH(QList<int>, ranges);
+
+        QList<int> positions;
+        const auto name = normalizeForMatching(path, &positions);
+        const auto normalizedQuery = normalizeForMatching(query).toCaseFolded();
+        MatchRanges matchRanges;
+        QVERIFY(matchPathFilter(QStringView(name).split(QLatin1Char('/')), QStringView(normalizedQuery).split(QLatin1Char('/'), Qt::SkipEmptyParts), &matchRanges)
+                > -1);
+        mapRanges(matchRanges, positions);
+        QCOMPARE(unpackRanges(matchRanges), ranges);
+    }
+
+    void testFuzzyMatcher()
+    {
+        const FuzzyMatcher matcher(QStringLiteral("gihtub"), 1);
+        QCOMPARE(matcher.match(QStringLiteral("web/github")), 1);
+        QCOMPARE(matcher.match(QStringLiteral("web/gihub")), 1);
+        QCOMPARE(matcher.match(QStringLiteral("web/gihtub")), 0);
+        QCOMPARE(matcher.match(QStringLiteral("web/gitlab")), -1);
+    }
+
+    void benchmarkSort_data()
+    {
+        QTest::addColumn<bool>("useSortKeys");
+
+        QTest::newRow("localeAwareCompare") << false;
+        QTest::newRow("QCollatorSortKey") << true;
+    }
+
+    void benchmarkSort()
+    {
+        QFETCH(bool, useSortKeys);
+
+        const auto corpus = realisticCorpus(50000);
+        QCollator collator;
+        std::vector<QCollatorSortKey> keys;
+        if (useSortKeys) {
+            keys.reserve(corpus.size());
+            for (const auto &path : corpus) {
+                keys.push_back(collator.sortKey(path));
+            }
+        }
+
+        std::vector<int> rows(corpus.size());
+        PerEntryReporter reporter(corpus.size());
+        QBENCHMARK {
+            std::iota(rows.begin(), rows.end(), 0);
+            if (useSortKeys) {
+                std::sort(rows.begin(), rows.end(), [&keys](int left, int right) {
+                    return keys[left].compare(keys[right]) < 0;
+                });
+            } else {
+                std::sort(rows.begin(), rows.end(), [&corpus](int left, int right) {
+                    return QString::localeAwareCompare(corpus.at(left), corpus.at(right)) < 0;
+                });
+            }
+            reporter.iterationDone();
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(MatchersBenchmark)
+
+#include "matchersbenchmark.moc"
@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "passwordlistmodel.h"
+#include "passwordsmodel.h"
+#include "passwordsortproxymodel.h"
+
+#include <KDescendantsProxyModel>
+
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace PlasmaPass;
+
+namespace
+{
+constexpr const int foldersPerLevel = 10;
+constexpr const int entriesPerFolder = 20;
+
+// Creates a store with folders nested "depth" levels deep, 22 220 entries in total for depth 3
+void createStore(const QDir &dir, int depth)
+{
+    for (int i = 0; i < entriesPerFolder; ++i) {
+        QFile file(dir.filePath(QStringLiteral("entry%1.gpg").arg(i)));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+    if (depth == 0) {
+        return;
+    }
+    for (int i = 0; i < foldersPerLevel; ++i) {
+        const auto name = QStringLiteral("folder%1").arg(i);
+        QVERIFY(dir.mkdir(name));
+        createStore(QDir(dir.filePath(name)), depth - 1);
+    }
+}
+
+qint64 allocatedBytes()
+{
+#ifdef __GLIBC__
+    const auto info = mallinfo2();
+    return static_cast<qint64>(info.uordblks + info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// The stack the filter used to search over: the tree sorted by a proxy, flattened by another one
+struct DescendantsStack {
+    explicit DescendantsStack(PasswordsModel *model)
+    {
+        sortModel.setSourceModel(model);
+        sortModel.setSortLocaleAware(true);
+        sortModel.setSortCaseSensitivity(Qt::CaseInsensitive);
+        sortModel.sort(0);
+        flatModel.setDisplayAncestorData(false);
+        flatModel.setSourceModel(&sortModel);
+    }
+
+    PasswordSortProxyModel sortModel;
+    KDescendantsProxyModel flatModel;
+};
+
+struct ListStack {
+    explicit ListStack(PasswordsModel *model)
+    {
+        flatModel.setPasswordsModel(model);
+    }
+
+    PasswordListModel flatModel;
+};
+
+// Reads the full name of every entry, like the filter does when it builds its row cache
+template<typename Stack>
+int readAll(Stack &stack)
+{
+    int entries = 0;
+    auto &model = stack.flatModel;
+    const int rows = model.rowCount();
+    for (int row = 0; row < rows; ++row) {
+        const auto index = model.index(row, 0);
+        if (index.data(PasswordsModel::EntryTypeRole).toInt() == PasswordsModel::PasswordEntry) {
+            entries += !index.data(PasswordsModel::FullNameRole).toString().isEmpty();
+        }
+    }
+    return entries;
+}
+
+} // namespace
+
+class ModelsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir mStoreDir;
+    std::unique_ptr<PasswordsModel> mModel;
+    int mEntries = 0;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QVERIFY(mStoreDir.isValid());
+        createStore(QDir(mStoreDir.path()), 3);
+        qputenv("PASSWORD_STORE_DIR", QFile::encodeName(mStoreDir.path()));
+        mModel = std::make_unique<PasswordsModel>();
+        mEntries = mModel->entryCount();
+        QCOMPARE(mEntries, entriesPerFolder * (1 + foldersPerLevel + foldersPerLevel * foldersPerLevel + foldersPerLevel * foldersPerLevel * foldersPerLevel));
+    }
+
+    void cleanupTestCase()
+    {
+        mModel.reset();
+    }
+
+    void benchmarkDescendantsProxy()
+    {
+        QBENCHMARK {
+            DescendantsStack stack(mModel.get());
+            QCOMPARE(readAll(stack), mEntries);
+        }
+    }
+
+    void benchmarkPasswordListModel()
+    {
+        QBENCHMARK {
+            ListStack stack(mModel.get());
+            QCOMPARE(readAll(stack), mEntries);
+        }
+    }
+
+    void benchmarkDescendantsProxyReadOnly()
+    {
+        DescendantsStack stack(mModel.get());
+        readAll(stack);
+        QBENCHMARK {
+            readAll(stack);
+        }
+    }
+
+    void benchmarkPasswordListModelReadOnly()
+    {
+        ListStack stack(mModel.get());
+        readAll(stack);
+        QBENCHMARK {
+            readAll(stack);
+        }
+    }
+
+    void testMemory()
+    {
+        if (allocatedBytes() < 0) {
+            QSKIP("Heap statistics are not available on this platform");
+        }
+
+        auto before = allocatedBytes();
+        auto descendants = std::make_unique<DescendantsStack>(mModel.get());
+        readAll(*descendants);
+        const auto descendantsBytes = allocatedBytes() - before;
+        descendants.reset();
+
+        before = allocatedBytes();
+        auto list = std::make_unique<ListStack>(mModel.get());
+        readAll(*list);
+        const auto listBytes = allocatedBytes() - before;
+        list.reset();
+
+        qInfo("KDescendantsProxyModel: %lld bytes, PasswordListModel: %lld bytes", descendantsBytes, listBytes);
+    }
+
+    void testSameEntries()
+    {
+        DescendantsStack descendants(mModel.get());
+        ListStack list(mModel.get());
+
+        QStringList descendantsNames;
+        for (int row = 0; row < descendants.flatModel.rowCount(); ++row) {
+            const auto index = descendants.flatModel.index(row, 0);
+            if (index.data(PasswordsModel::EntryTypeRole).toInt() == PasswordsModel::PasswordEntry) {
+                descendantsNames.push_back(index.data(PasswordsModel::FullNameRole).toString());
+            }
+        }
+        QStringList listNames;
+        for (int row = 0; row < list.flatModel.rowCount(); ++row) {
+            listNames.push_back(list.flatModel.index(row, 0).data(PasswordsModel::FullNameRole).toString());
+        }
+
+        descendantsNames.sort();
+        listNames.sort();
+        QCOMPARE(listNames, descendantsNames);
+    }
+};
+
+QTEST_GUILESS_MAIN(ModelsBenchmark)
+
+#include "modelsbenchmark.moc"
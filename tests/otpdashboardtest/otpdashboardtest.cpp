@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "gpgtestenv.h"
+#include "otpdashboard.h"
+#include "totpgenerator.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace PlasmaPass;
+
+namespace
+{
+const QString otpUri = QStringLiteral("otpauth://totp/test?secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+
+} // namespace
+
+class OTPDashboardTest : public QObject
+{
+    Q_OBJECT
+
+    bool addEntry(const QString &fullName, const QByteArray &plainText)
+    {
+        return mGpg.encrypt(plainText, mStore.absoluteFilePath(fullName + QStringLiteral(".gpg")));
+    }
+
+    GpgTestEnv mGpg;
+    QTemporaryDir mDir;
+    QDir mStore;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        if (!GpgTestEnv::isAvailable()) {
+            QSKIP("gpg is not installed");
+        }
+        QVERIFY(mDir.isValid());
+        QVERIFY(mGpg.init());
+
+        mStore.setPath(mDir.filePath(QStringLiteral("store")));
+        QVERIFY(QDir().mkpath(mStore.absolutePath()));
+        qputenv("PASSWORD_STORE_DIR", QFile::encodeName(mStore.absolutePath()));
+
+        QVERIFY(addEntry(QStringLiteral("web/forum"), "123456\n" + otpUri.toUtf8() + "\n"));
+        QVERIFY(addEntry(QStringLiteral("web/shop"), QByteArrayLiteral("123456\n")));
+        QVERIFY(addEntry(QStringLiteral("work/vpn"), "T7#qz!Lm2@vRx9&Kp4$w\nlogin: user\n" + otpUri.toUtf8() + "&digits=8\n"));
+        QFile broken(mStore.absoluteFilePath(QStringLiteral("work/broken.gpg")));
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        QVERIFY(broken.write("not encrypted at all") > 0);
+    }
+
+    void testDashboard()
+    {
+        TOTPGenerator generator;
+        QVERIFY(generator.load(otpUri).isNull());
+
+        OTPDashboard dashboard;
+        dashboard.start();
+        QVERIFY(dashboard.isLoading());
+        QCOMPARE(dashboard.total(), 4);
+        QTRY_VERIFY_WITH_TIMEOUT(!dashboard.isLoading(), 60000);
+
+        QCOMPARE(dashboard.done(), 4);
+        QCOMPARE(dashboard.failedCount(), 1);
+        QCOMPARE(dashboard.rowCount(), 2);
+        QCOMPARE(dashboard.index(0).data(OTPDashboard::FullNameRole).toString(), QStringLiteral("web/forum"));
+        QCOMPARE(dashboard.index(1).data(OTPDashboard::FullNameRole).toString(), QStringLiteral("work/vpn"));
+
+        // Both codes change at the same time, the 8-digit one ends with the 6-digit one
+        const auto now = QDateTime::currentMSecsSinceEpoch();
+        QVERIFY(dashboard.nextRefresh() > now);
+        QVERIFY(dashboard.nextRefresh() <= now + 30000);
+        QTRY_COMPARE(dashboard.index(0).data(OTPDashboard::CodeRole).toString(),
+                     generator.code(QDateTime::currentSecsSinceEpoch()).toString());
+        QVERIFY(dashboard.index(1).data(OTPDashboard::CodeRole).toString().endsWith(dashboard.index(0).data(OTPDashboard::CodeRole).toString()));
+
+        // Once the step is over, all codes are regenerated by the one shared deadline
+        const auto nextRefresh = dashboard.nextRefresh();
+        QTRY_VERIFY_WITH_TIMEOUT(dashboard.nextRefresh() > nextRefresh, 35000);
+        QCOMPARE(dashboard.index(0).data(OTPDashboard::CodeRole).toString(), generator.code(nextRefresh / 1000).toString());
+        QCOMPARE(dashboard.nextRefresh(), nextRefresh + 30000);
+
+        dashboard.stop();
+        QCOMPARE(dashboard.rowCount(), 0);
+        QCOMPARE(dashboard.nextRefresh(), qint64(0));
+    }
+
+    void testSkipsEntriesWithoutOtp()
+    {
+        // testDashboard() found web/shop without OTP, which outlives its dashboard
+        OTPDashboard dashboard;
+        dashboard.start();
+        QCOMPARE(dashboard.total(), 3);
+        QTRY_VERIFY_WITH_TIMEOUT(!dashboard.isLoading(), 60000);
+        QCOMPARE(dashboard.rowCount(), 2);
+
+        // Decrypted again once it has changed
+        QVERIFY(addEntry(QStringLiteral("web/shop"), QByteArrayLiteral("654321\n")));
+        dashboard.start();
+        QCOMPARE(dashboard.total(), 4);
+        QTRY_VERIFY_WITH_TIMEOUT(!dashboard.isLoading(), 60000);
+        QCOMPARE(dashboard.rowCount(), 2);
+
+        dashboard.start();
+        QCOMPARE(dashboard.total(), 3);
+        QTRY_VERIFY_WITH_TIMEOUT(!dashboard.isLoading(), 60000);
+    }
+
+    void testFolder()
+    {
+        OTPDashboard dashboard;
+        dashboard.setFolder(QStringLiteral("work"));
+        dashboard.start();
+        QCOMPARE(dashboard.total(), 2);
+        QTRY_VERIFY_WITH_TIMEOUT(!dashboard.isLoading(), 60000);
+        QCOMPARE(dashboard.rowCount(), 1);
+        QCOMPARE(dashboard.index(0).data(OTPDashboard::FullNameRole).toString(), QStringLiteral("work/vpn"));
+    }
+};
+
+QTEST_GUILESS_MAIN(OTPDashboardTest)
+
+#include "otpdashboardtest.moc"
@@ -0,0 +1,138 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "decryptionservice.h"
+#include "gpgtestenv.h"
+#include "passwordaudit.h"
+
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace PlasmaPass;
+
+class PasswordAuditTest : public QObject
+{
+    Q_OBJECT
+
+    bool addEntry(const QString &fullName, const QByteArray &plainText)
+    {
+        return mGpg.encrypt(plainText, mStore.absoluteFilePath(fullName + QStringLiteral(".gpg")));
+    }
+
+    GpgTestEnv mGpg;
+    QTemporaryDir mDir;
+    QDir mStore;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        if (!GpgTestEnv::isAvailable()) {
+            QSKIP("gpg is not installed");
+        }
+        QVERIFY(mDir.isValid());
+        QVERIFY(mGpg.init());
+
+        mStore.setPath(mDir.filePath(QStringLiteral("store")));
+        QVERIFY(QDir().mkpath(mStore.absolutePath()));
+        qputenv("PASSWORD_STORE_DIR", QFile::encodeName(mStore.absolutePath()));
+
+        QVERIFY(addEntry(QStringLiteral("web/forum"), QByteArrayLiteral("123456\nlogin: user\n")));
+        QVERIFY(addEntry(QStringLiteral("web/shop"), QByteArrayLiteral("123456\n")));
+        QVERIFY(addEntry(QStringLiteral("work/vpn"), QByteArrayLiteral("T7#qz!Lm2@vRx9&Kp4$w\notpauth://totp/vpn?secret=JBSWY3DPEHPK3PXP\n")));
+        QFile broken(mStore.absoluteFilePath(QStringLiteral("work/broken.gpg")));
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        QVERIFY(broken.write("not encrypted at all") > 0);
+    }
+
+    void testAudit()
+    {
+        PasswordAudit audit;
+        audit.start();
+        QVERIFY(audit.isRunning());
+        QCOMPARE(audit.total(), 4);
+        QTRY_VERIFY_WITH_TIMEOUT(!audit.isRunning(), 60000);
+
+        QCOMPARE(audit.done(), 4);
+        QCOMPARE(audit.rowCount(), 4);
+        QCOMPARE(audit.weakCount(), 2);
+        QCOMPARE(audit.reusedCount(), 2);
+        QCOMPARE(audit.missingOtpCount(), 2);
+        QCOMPARE(audit.failedCount(), 1);
+
+        for (int row = 0; row < audit.rowCount(); ++row) {
+            const auto index = audit.index(row);
+            const auto fullName = index.data(PasswordAudit::FullNameRole).toString();
+            if (fullName == QLatin1String("work/vpn")) {
+                QCOMPARE(index.data(PasswordAudit::StrengthRole).toInt(), 4);
+                QCOMPARE(index.data(PasswordAudit::ReusedRole).toInt(), 0);
+                QVERIFY(index.data(PasswordAudit::HasOTPRole).toBool());
+            } else if (fullName == QLatin1String("work/broken")) {
+                QVERIFY(!index.data(PasswordAudit::ErrorRole).toString().isEmpty());
+            } else {
+                QCOMPARE(index.data(PasswordAudit::StrengthRole).toInt(), 0);
+                QCOMPARE(index.data(PasswordAudit::ReusedRole).toInt(), 1);
+            }
+        }
+
+        // Only the failed entry is audited again
+        audit.start();
+        QCOMPARE(audit.total(), 1);
+        QTRY_VERIFY_WITH_TIMEOUT(!audit.isRunning(), 60000);
+        QCOMPARE(audit.rowCount(), 4);
+        QCOMPARE(audit.failedCount(), 1);
+    }
+
+    void testFolder()
+    {
+        PasswordAudit audit;
+        audit.setFolder(QStringLiteral("web"));
+        audit.start();
+        QCOMPARE(audit.total(), 2);
+        QTRY_VERIFY_WITH_TIMEOUT(!audit.isRunning(), 60000);
+        QCOMPARE(audit.reusedCount(), 2);
+        QCOMPARE(audit.failedCount(), 0);
+    }
+
+    void testCancelWaiting()
+    {
+        // Four entries for two workers, those of the second audit wait for the first ones
+        PasswordAudit web;
+        web.setFolder(QStringLiteral("web"));
+        web.start();
+        PasswordAudit work;
+        work.setFolder(QStringLiteral("work"));
+        work.start();
+
+        // Closing the popup does not cancel the audits
+        DecryptionService::instance()->cancelWaiting();
+        QTRY_VERIFY_WITH_TIMEOUT(!web.isRunning() && !work.isRunning(), 60000);
+        QCOMPARE(web.rowCount(), 2);
+        QCOMPARE(web.failedCount(), 0);
+        QCOMPARE(work.rowCount(), 2);
+        QCOMPARE(work.failedCount(), 1);
+    }
+
+    void testCancelAndResume()
+    {
+        PasswordAudit audit;
+        audit.start();
+        QCOMPARE(audit.total(), 4);
+        audit.cancel();
+        QVERIFY(!audit.isRunning());
+        const auto audited = audit.rowCount();
+        QVERIFY(audited < 4);
+
+        audit.start();
+        QCOMPARE(audit.total(), 4 - audited);
+        QTRY_VERIFY_WITH_TIMEOUT(!audit.isRunning(), 60000);
+        QCOMPARE(audit.rowCount(), 4);
+    }
+};
+
+QTEST_GUILESS_MAIN(PasswordAuditTest)
+
+#include "passwordaudittest.moc"
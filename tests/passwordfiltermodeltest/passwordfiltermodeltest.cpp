@@ -0,0 +1,341 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "passwordfiltermodel.h"
+#include "passwordsmodel.h"
+#include "usagestore.h"
+
+#include <QAbstractItemModelTester>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+
+using namespace PlasmaPass;
+
+namespace
+{
+QStringList fullNames(const QAbstractItemModel &model)
+{
+    QStringList names;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        names.push_back(model.index(row, 0).data(PasswordsModel::FullNameRole).toString());
+    }
+    return names;
+}
+
+// Names that contain neither "p" nor "q" but in the suffix, sorted the same way as the model sorts them
+QStringList entryNames(int count, const QStringList &suffixes)
+{
+    QStringList names;
+    for (int i = 0; i < count; ++i) {
+        for (const auto &suffix : suffixes) {
+            names.push_back(QStringLiteral("item%1-%2").arg(i, 3, 10, QLatin1Char('0')).arg(suffix));
+        }
+    }
+    return names;
+}
+
+/**
+ * Follows the rows of a model through its change signals only, so the rows it ends up with
+ * tell whether the signals describe the changes correctly.
+ */
+class RowMirror : public QObject
+{
+public:
+    explicit RowMirror(QAbstractItemModel *model)
+        : rows(fullNames(*model))
+    {
+        connect(model, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+            rows.remove(first, last - first + 1);
+        });
+        connect(model, &QAbstractItemModel::rowsMoved, this, [this](const QModelIndex &, int first, int last, const QModelIndex &, int row) {
+            const auto moved = rows.mid(first, last - first + 1);
+            rows.remove(first, moved.size());
+            // The destination row is counted before the moved rows were taken out
+            const auto to = row > last ? row - moved.size() : row;
+            for (int i = 0; i < moved.size(); ++i) {
+                rows.insert(to + i, moved.at(i));
+            }
+        });
+        connect(model, &QAbstractItemModel::rowsInserted, this, [this, model](const QModelIndex &, int first, int last) {
+            for (int row = first; row <= last; ++row) {
+                rows.insert(row, model->index(row, 0).data(PasswordsModel::FullNameRole).toString());
+            }
+        });
+        connect(model, &QAbstractItemModel::modelReset, this, [this, model]() {
+            rows = fullNames(*model);
+        });
+    }
+
+    QStringList rows;
+};
+
+} // namespace
+
+class PasswordFilterModelTest : public QObject
+{
+    Q_OBJECT
+
+    // Creates the entries as empty files, the models never decrypt them
+    void createStore(const QStringList &names)
+    {
+        mDir = std::make_unique<QTemporaryDir>();
+        QVERIFY(mDir->isValid());
+        for (const auto &name : names) {
+            const auto path = mDir->filePath(name + QStringLiteral(".gpg"));
+            QVERIFY(QDir().mkpath(QFileInfo(path).absolutePath()));
+            QFile file(path);
+            QVERIFY(file.open(QIODevice::WriteOnly));
+        }
+        qputenv("PASSWORD_STORE_DIR", QFile::encodeName(mDir->path()));
+    }
+
+    // Entries for the "re:" and "glob:" filters, one of them with a ligature that
+    // normalizeForMatching() expands to two characters
+    void createPatternStore()
+    {
+        createStore({QStringLiteral("prod/db"),
+                     QStringLiteral("prod/userdb"),
+                     QStringLiteral("prod/web"),
+                     QStringLiteral("staging/prod/db"),
+                     QStringLiteral("vault/42"),
+                     QStringLiteral("\uFB01nance/bank")});
+    }
+
+    // The first filter is always matched in a worker, wait for the results
+    void setFilter(PasswordFilterModel &model, const QString &filter)
+    {
+        model.setPasswordFilter(filter);
+        QTRY_COMPARE(model.passwordFilter(), filter);
+    }
+
+    std::unique_ptr<QTemporaryDir> mDir;
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+        // Usage left over from a previous run would change the order of the rows
+        QFile::remove(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/plasma-pass/usage"));
+    }
+
+    void testRemovals()
+    {
+        createStore(entryNames(10, {QStringLiteral("p"), QStringLiteral("q")}));
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setFuzzyMatching(false);
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+        QCOMPARE(model.rowCount(), 20);
+
+        RowMirror mirror(&model);
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        setFilter(model, QStringLiteral("p"));
+        // Each "q" entry sits between two "p" entries, so each is a run of its own
+        QCOMPARE(removedSpy.count(), 10);
+        QCOMPARE(movedSpy.count(), 0);
+        QCOMPARE(insertedSpy.count(), 0);
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(fullNames(model), entryNames(10, {QStringLiteral("p")}));
+        QCOMPARE(mirror.rows, fullNames(model));
+    }
+
+    void testInsertions()
+    {
+        createStore(entryNames(10, {QStringLiteral("p"), QStringLiteral("q")}));
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setFuzzyMatching(false);
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+        setFilter(model, QStringLiteral("p"));
+
+        RowMirror mirror(&model);
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        setFilter(model, QString());
+        QCOMPARE(removedSpy.count(), 0);
+        QCOMPARE(movedSpy.count(), 0);
+        QCOMPARE(insertedSpy.count(), 10);
+        QCOMPARE(resetSpy.count(), 0);
+        QCOMPARE(fullNames(model), entryNames(10, {QStringLiteral("p"), QStringLiteral("q")}));
+        QCOMPARE(mirror.rows, fullNames(model));
+    }
+
+    void testMoves()
+    {
+        createStore(entryNames(10, {QStringLiteral("p"), QStringLiteral("q")}));
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setFuzzyMatching(false);
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+        setFilter(model, QStringLiteral("p"));
+
+        RowMirror mirror(&model);
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy movedSpy(&model, &QAbstractItemModel::rowsMoved);
+        QSignalSpy insertedSpy(&model, &QAbstractItemModel::rowsInserted);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        // Matches the same entries equally well, the used one goes first now and only it moves
+        const auto used = QStringLiteral("item009-p");
+        UsageStore::instance()->recordUsage(used);
+        setFilter(model, QStringLiteral("-p"));
+        QCOMPARE(removedSpy.count(), 0);
+        QCOMPARE(movedSpy.count(), 1);
+        QCOMPARE(insertedSpy.count(), 0);
+        QCOMPARE(resetSpy.count(), 0);
+        auto expected = entryNames(10, {QStringLiteral("p")});
+        expected.removeOne(used);
+        expected.prepend(used);
+        QCOMPARE(fullNames(model), expected);
+        QCOMPARE(mirror.rows, fullNames(model));
+
+        // Back to the first filter, which was matched before the usage changed
+        setFilter(model, QStringLiteral("p"));
+        QCOMPARE(movedSpy.count(), 1);
+        QCOMPARE(mirror.rows, fullNames(model));
+    }
+
+    void testResetFallback_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::addColumn<bool>("reset");
+
+        // Removing every other entry takes one change per removed entry
+        QTest::newRow("few changes") << 250 << false;
+        QTest::newRow("many changes") << 300 << true;
+    }
+
+    void testResetFallback()
+    {
+        QFETCH(int, count);
+        QFETCH(bool, reset);
+
+        createStore(entryNames(count, {QStringLiteral("p"), QStringLiteral("q")}));
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setFuzzyMatching(false);
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        RowMirror mirror(&model);
+        QSignalSpy removedSpy(&model, &QAbstractItemModel::rowsRemoved);
+        QSignalSpy resetSpy(&model, &QAbstractItemModel::modelReset);
+
+        setFilter(model, QStringLiteral("p"));
+        QCOMPARE(resetSpy.count(), reset ? 1 : 0);
+        QCOMPARE(removedSpy.count(), reset ? 0 : count);
+        QCOMPARE(fullNames(model), entryNames(count, {QStringLiteral("p")}));
+        QCOMPARE(mirror.rows, fullNames(model));
+    }
+
+    void testPatterns_data()
+    {
+        QTest::addColumn<QString>("filter");
+        QTest::addColumn<QStringList>("expected");
+
+        QTest::newRow("regex anchored") << QStringLiteral("re:^prod/.*db$") << QStringList{QStringLiteral("prod/db"), QStringLiteral("prod/userdb")};
+        QTest::newRow("regex unanchored") << QStringLiteral("re:prod/db") << QStringList{QStringLiteral("prod/db"), QStringLiteral("staging/prod/db")};
+        QTest::newRow("regex case-insensitive") << QStringLiteral("re:PROD/WEB") << QStringList{QStringLiteral("prod/web")};
+        QTest::newRow("regex without ligature") << QStringLiteral("re:^finance/") << QStringList{QStringLiteral("\uFB01nance/bank")};
+        QTest::newRow("regex invalid") << QStringLiteral("re:(") << QStringList{};
+        QTest::newRow("glob whole name") << QStringLiteral("glob:prod/*") << QStringList{QStringLiteral("prod/db"), QStringLiteral("prod/userdb"), QStringLiteral("prod/web")};
+        QTest::newRow("glob star in one folder") << QStringLiteral("glob:*/db") << QStringList{QStringLiteral("prod/db")};
+        QTest::newRow("glob star in two folders") << QStringLiteral("glob:*/*/db") << QStringList{QStringLiteral("staging/prod/db")};
+        QTest::newRow("glob question mark") << QStringLiteral("glob:vault/4?") << QStringList{QStringLiteral("vault/42")};
+        QTest::newRow("glob no match") << QStringLiteral("glob:db") << QStringList{};
+    }
+
+    void testPatterns()
+    {
+        QFETCH(QString, filter);
+        QFETCH(QStringList, expected);
+
+        createPatternStore();
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        setFilter(model, filter);
+        // All pattern matches are equally good, the order is up to the collation
+        auto names = fullNames(model);
+        names.sort();
+        expected.sort();
+        QCOMPARE(names, expected);
+    }
+
+    void testPatternCacheKey()
+    {
+        createPatternStore();
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setSourceModel(&passwords);
+        QAbstractItemModelTester tester(&model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+        // The patterns differ only in case and must not share the cached results
+        setFilter(model, QStringLiteral("re:\\d"));
+        QCOMPARE(fullNames(model), QStringList{QStringLiteral("vault/42")});
+        setFilter(model, QStringLiteral("re:\\D"));
+        QCOMPARE(model.rowCount(), 6);
+        setFilter(model, QStringLiteral("re:\\d"));
+        QCOMPARE(fullNames(model), QStringList{QStringLiteral("vault/42")});
+        setFilter(model, QStringLiteral("re:\\D"));
+        QCOMPARE(model.rowCount(), 6);
+    }
+
+    void testPatternRanges_data()
+    {
+        QTest::addColumn<QString>("filter");
+        QTest::addColumn<QString>("fullName");
+        QTest::addColumn<QList<int>>("ranges");
+
+        QTest::newRow("regex") << QStringLiteral("re:db$") << QStringLiteral("staging/prod/db") << QList<int>{13, 2};
+        QTest::newRow("glob") << QStringLiteral("glob:prod/w*") << QStringLiteral("prod/web") << QList<int>{0, 8};
+        // The ligature is one character of the full name, but two of the name that is matched
+        QTest::newRow("ligature") << QStringLiteral("re:^fin") << QStringLiteral("\uFB01nance/bank") << QList<int>{0, 2};
+        QTest::newRow("part of ligature") << QStringLiteral("re:^f") << QStringLiteral("\uFB01nance/bank") << QList<int>{0, 1};
+        QTest::newRow("after ligature") << QStringLiteral("re:bank") << QStringLiteral("\uFB01nance/bank") << QList<int>{7, 4};
+        QTest::newRow("glob with ligature") << QStringLiteral("glob:*/bank") << QStringLiteral("\uFB01nance/bank") << QList<int>{0, 11};
+    }
+
+    void testPatternRanges()
+    {
+        QFETCH(QString, filter);
+        QFETCH(QString, fullName);
+        QFETCH(QList<int>, ranges);
+
+        createPatternStore();
+        PasswordsModel passwords;
+        PasswordFilterModel model;
+        model.setSourceModel(&passwords);
+        setFilter(model, filter);
+
+        const auto names = fullNames(model);
+        const auto row = names.indexOf(fullName);
+        QVERIFY(row != -1);
+        QCOMPARE(model.index(row, 0).data(PasswordsModel::MatchRangesRole).value<QList<int>>(), ranges);
+    }
+};
+
+QTEST_GUILESS_MAIN(PasswordFilterModelTest)
+
+#include "passwordfiltermodeltest.moc"
@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "secretbuffer.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <algorithm>
+#include <utility>
+
+using namespace PlasmaPass;
+
+class SecretBufferTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testNull()
+    {
+        SecretBuffer buffer;
+        QVERIFY(buffer.isNull());
+        QVERIFY(buffer.toString().isNull());
+
+        // Even an empty secret is a secret
+        SecretBuffer empty{QStringView()};
+        QVERIFY(!empty.isNull());
+        QCOMPARE(empty.size(), qsizetype(0));
+
+        empty.clear();
+        QVERIFY(empty.isNull());
+    }
+
+    void testAppend()
+    {
+        SecretBuffer buffer(u"pass");
+        buffer.append(u"word");
+        QCOMPARE(buffer.toString(), QStringLiteral("password"));
+
+        // Grows over several pages
+        const QString longText(10000, QLatin1Char('x'));
+        buffer.append(longText);
+        QCOMPARE(buffer.size(), 8 + longText.size());
+        QVERIFY(buffer.view().startsWith(u"password"));
+        QVERIFY(buffer.view().endsWith(longText));
+
+        buffer.truncate(4);
+        QCOMPARE(buffer.toString(), QStringLiteral("pass"));
+    }
+
+    void testAppendUtf8()
+    {
+        const QByteArray utf8 = QStringLiteral("heslo: žluťoučký kůň\n").toUtf8();
+        QStringDecoder decoder(QStringDecoder::Utf8);
+        SecretBuffer buffer;
+        // Split in the middle of every multi-byte character at some point
+        for (qsizetype i = 0; i < utf8.size(); i += 3) {
+            buffer.appendUtf8(decoder, QByteArrayView(utf8).sliced(i, std::min<qsizetype>(3, utf8.size() - i)));
+        }
+        QCOMPARE(buffer.toString(), QStringLiteral("heslo: žluťoučký kůň\n"));
+
+        QCOMPARE(SecretBuffer::fromUtf8("123456").toString(), QStringLiteral("123456"));
+    }
+
+    void testMove()
+    {
+        SecretBuffer buffer(u"secret");
+        const auto data = buffer.view().data();
+
+        SecretBuffer moved(std::move(buffer));
+        QVERIFY(buffer.isNull()); // NOLINT(bugprone-use-after-move)
+        QCOMPARE(moved.toString(), QStringLiteral("secret"));
+        // The text itself is not copied
+        QCOMPARE(moved.view().data(), data);
+
+        SecretBuffer assigned(u"other");
+        assigned = std::move(moved);
+        QCOMPARE(assigned.toString(), QStringLiteral("secret"));
+        QVERIFY(moved.isNull()); // NOLINT(bugprone-use-after-move)
+    }
+};
+
+QTEST_GUILESS_MAIN(SecretBufferTest)
+
+#include "secretbuffertest.moc"
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 Plasma Pass contributors <plasma-devel@kde.org>
+//
+// SPDX-License-Identifier: LGPL-2.1-or-later
+
+#include "totpgenerator.h"
+
+#include <QObject>
+#include <QTest>
+
+using namespace PlasmaPass;
+
+namespace
+{
+// The key of the SHA1 test vectors in RFC 6238, "12345678901234567890" in base32
+const QString rfcUri = QStringLiteral("otpauth://totp/test?secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+
+} // namespace
+
+class TOTPGeneratorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testCode_data()
+    {
+        QTest::addColumn<qint64>("time");
+        QTest::addColumn<QString>("code");
+
+        QTest::newRow("59") << qint64(59) << QStringLiteral("94287082");
+        QTest::newRow("1111111109") << qint64(1111111109) << QStringLiteral("07081804");
+        QTest::newRow("1234567890") << qint64(1234567890) << QStringLiteral("89005924");
+        QTest::newRow("20000000000") << qint64(20000000000) << QStringLiteral("65353130");
+    }
+
+    void testCode()
+    {
+        QFETCH(qint64, time);
+        QFETCH(QString, code);
+
+        TOTPGenerator generator;
+        QVERIFY(generator.load(QString(rfcUri + QStringLiteral("&digits=8"))).isNull());
+        QCOMPARE(generator.code(time).toString(), code);
+        // The default is 6 digits, the last ones of the same code
+        QVERIFY(generator.load(rfcUri).isNull());
+        QCOMPARE(generator.code(time).toString(), code.right(6));
+    }
+
+    void testQuery_data()
+    {
+        QTest::addColumn<QString>("uri");
+
+        QTest::newRow("secret first") << QStringLiteral("otpauth://totp/test?secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ&digits=8");
+        QTest::newRow("secret in between") << QStringLiteral("otpauth://totp/Example:test?issuer=Example&secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ&digits=8");
+        QTest::newRow("secret last") << QStringLiteral("otpauth://totp/test?digits=8&secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ");
+        QTest::newRow("percent-encoded") << QStringLiteral("otpauth://totp/test?digits=8&secret=GEZDGNBVGY3TQOJQ%47EZDGNBVGY3TQOJQ");
+        QTest::newRow("fragment") << QStringLiteral("otpauth://totp/test?digits=8&secret=GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ#secret=AAAA");
+    }
+
+    void testQuery()
+    {
+        QFETCH(QString, uri);
+
+        TOTPGenerator generator;
+        QVERIFY(generator.load(uri).isNull());
+        QCOMPARE(generator.code(59).toString(), QStringLiteral("94287082"));
+    }
+
+    void testSteps()
+    {
+        TOTPGenerator generator;
+        QVERIFY(generator.load(QString(rfcUri + QStringLiteral("&period=60"))).isNull());
+        QCOMPARE(generator.period(), 60);
+        QCOMPARE(generator.nextStep(0), qint64(60));
+        QCOMPARE(generator.nextStep(59), qint64(60));
+        QCOMPARE(generator.nextStep(60), qint64(120));
+        QCOMPARE(generator.code(60).toString(), generator.code(119).toString());
+        QVERIFY(generator.code(119).toString() != generator.code(120).toString());
+    }
+
+    void testClear()
+    {
+        TOTPGenerator generator;
+        QVERIFY(generator.isNull());
+        QVERIFY(generator.load(rfcUri).isNull());
+        QVERIFY(!generator.isNull());
+        generator.clear();
+        QVERIFY(generator.isNull());
+        QVERIFY(generator.code(59).isNull());
+    }
+
+    void testInvalid()
+    {
+        TOTPGenerator generator;
+        QVERIFY(!generator.load(QStringLiteral("otpauth://hotp/test?secret=GEZDGNBVGY3TQOJQ&counter=0")).isNull());
+        QVERIFY(!generator.load(QStringLiteral("otpauth://totp/test?secret=!!!")).isNull());
+        QVERIFY(!generator.load(QStringLiteral("otpauth://totp/test?issuer=Example")).isNull());
+        QVERIFY(!generator.load(QStringLiteral("otpauth://totp/test?secret=GEZDGNBVGY3TQOJQ\u00e9")).isNull());
+        QVERIFY(!generator.load(QString(rfcUri + QStringLiteral("&digits=4"))).isNull());
+        QVERIFY(!generator.load(QString(rfcUri + QStringLiteral("&period=0"))).isNull());
+        QVERIFY(generator.isNull());
+    }
+};
+
+QTEST_GUILESS_MAIN(TOTPGeneratorTest)
+
+#include "totpgeneratortest.moc"